@@ -0,0 +1,207 @@
+#include "header.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <list>
+
+using core::check;
+using core::HashWrapper;
+using core::hashed;
+using core::u8string;
+using core::BloomFilter;
+using core::FlatHashSet;
+using core::PlainException;
+using std::vector;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+// A key that counts how often it is hashed.
+struct CountedKey {
+  size_t *hashCount;
+  size_t v;
+
+  friend size_t hashFast (const CountedKey &o) noexcept {
+    ++*o.hashCount;
+    return o.v;
+  }
+
+  friend bool operator== (const CountedKey &l, const CountedKey &r) noexcept {
+    return l.v == r.v;
+  }
+};
+
+size_t getFalsePositiveCount (const BloomFilter &filter, size_t start, size_t end) {
+  size_t count = 0;
+  for (size_t n = start; n != end; ++n) {
+    count += filter.mayContain(hashed(createKey(n)));
+  }
+  return count;
+}
+
+}
+
+void testBloomFilter () {
+  const size_t keyCount = 10000;
+  BloomFilter filter(keyCount, 0.01);
+  check(0U, getFalsePositiveCount(filter, 0, keyCount));
+  for (size_t n = 0; n != keyCount; ++n) {
+    filter.insert(hashed(createKey(n)));
+  }
+  for (size_t n = 0; n != keyCount; ++n) {
+    check(filter.mayContain(hashed(createKey(n))));
+  }
+
+  // Check that the rates (both expected and measured) are near the one asked
+  // for, and that the size is near the theoretical one for a blocked filter.
+  double expectedRate = filter.getFalsePositiveRate(keyCount);
+  check(expectedRate > 0.005 && expectedRate <= 0.0101);
+  check(filter.getFalsePositiveRate(keyCount / 2) < expectedRate);
+  size_t falsePositiveCount = getFalsePositiveCount(filter, keyCount, keyCount * 11);
+  check(falsePositiveCount > keyCount * 10 / 200 && falsePositiveCount < keyCount * 10 / 50);
+  check(filter.getSize() % 32 == 0);
+  check(filter.getSize() > keyCount && filter.getSize() < keyCount * 3);
+
+  // Check that keys' stored hash values are used.
+  size_t hashCount = 0;
+  BloomFilter countedFilter(100, 0.01);
+  countedFilter.insert(CountedKey{&hashCount, 12345});
+  check(1U, hashCount);
+  check(countedFilter.mayContain(CountedKey{&hashCount, 12345}));
+  check(2U, hashCount);
+  check(countedFilter.mayContainHash(12345));
+
+  // Check that a filter survives being written and read back.
+  vector<iu8f> octets;
+  auto out = std::back_inserter(octets);
+  filter.write(out);
+  check(filter.getWrittenSize(), octets.size());
+  const iu8f *ptr = octets.data();
+  BloomFilter reread = BloomFilter::read(ptr, octets.data() + octets.size());
+  check(octets.data() + octets.size() == ptr);
+  check(filter.getSize(), reread.getSize());
+  for (size_t n = 0; n != keyCount; ++n) {
+    check(reread.mayContain(hashed(createKey(n))));
+  }
+  check(falsePositiveCount, getFalsePositiveCount(reread, keyCount, keyCount * 11));
+
+  // Check that bad streams are rejected.
+  ptr = octets.data();
+  try {
+    BloomFilter::read(ptr, octets.data() + octets.size() - 1);
+    check(false);
+  } catch (const PlainException &) {
+  }
+  vector<iu8f> badOctets(octets);
+  badOctets[0] = 99;
+  ptr = badOctets.data();
+  try {
+    BloomFilter::read(ptr, badOctets.data() + badOctets.size());
+    check(false);
+  } catch (const PlainException &) {
+  }
+
+  // Check that a huge block count is rejected before the blocks are allocated
+  // (whether or not the stream's length is known) and that a big filter is
+  // read from a stream of unknown length.
+  const iu8f hugeOctets[] = {1, 0x80, 0x80, 0x80, 0x80, 0x08};
+  ptr = hugeOctets;
+  try {
+    BloomFilter::read(ptr, hugeOctets + sizeof(hugeOctets));
+    check(false);
+  } catch (const PlainException &) {
+  }
+  std::list<iu8f> hugeList(hugeOctets, hugeOctets + sizeof(hugeOctets));
+  auto hugeI = hugeList.cbegin();
+  try {
+    BloomFilter::read(hugeI, hugeList.cend());
+    check(false);
+  } catch (const PlainException &) {
+  }
+  BloomFilter big(keyCount * 20, 0.01);
+  for (size_t n = 0; n != keyCount; ++n) {
+    big.insert(hashed(createKey(n)));
+  }
+  std::list<iu8f> bigList;
+  auto bigOut = std::back_inserter(bigList);
+  big.write(bigOut);
+  auto bigI = bigList.cbegin();
+  BloomFilter bigReread = BloomFilter::read(bigI, bigList.cend());
+  check(bigList.cend() == bigI);
+  check(big.getSize(), bigReread.getSize());
+  check(big.getSize() > 4096U * 32U);
+  for (size_t n = 0; n != keyCount; ++n) {
+    check(bigReread.mayContain(hashed(createKey(n))));
+  }
+
+  // Check merging and clearing.
+  BloomFilter filter0(keyCount, 0.01), filter1(keyCount, 0.01);
+  for (size_t n = 0; n != keyCount; ++n) {
+    (n % 2 == 0 ? filter0 : filter1).insert(hashed(createKey(n)));
+  }
+  filter0.merge(filter1);
+  for (size_t n = 0; n != keyCount; ++n) {
+    check(filter0.mayContain(hashed(createKey(n))));
+  }
+  filter0.clear();
+  check(0U, getFalsePositiveCount(filter0, 0, keyCount));
+
+  // Check that tiny filters still work.
+  BloomFilter tiny(0, 0.5);
+  check(32U, tiny.getSize());
+  tiny.insert(hashed(createKey(1)));
+  check(tiny.mayContain(hashed(createKey(1))));
+}
+
+void benchmarkBloomFilter () {
+  typedef std::chrono::steady_clock Clock;
+  const size_t keyCount = 1000000;
+  vector<HashWrapper<u8string>> keys, missingKeys;
+  for (size_t n = 0; n != keyCount; ++n) {
+    keys.push_back(hashed(createKey(n)));
+    missingKeys.push_back(hashed(createKey(n + keyCount)));
+  }
+
+  BloomFilter filter(keyCount, 0.01);
+  FlatHashSet<HashWrapper<u8string>> set;
+  for (const HashWrapper<u8string> &key : keys) {
+    filter.insert(key);
+    set.insert(key);
+  }
+
+  printf("%-24s %12s %12s\n", "", "hits (ns)", "misses (ns)");
+  auto time = [&] (auto &&lookup) {
+    double nss[2];
+    for (size_t i = 0; i != 2; ++i) {
+      size_t found = 0;
+      auto start = Clock::now();
+      for (const HashWrapper<u8string> &key : i == 0 ? keys : missingKeys) {
+        found += lookup(key);
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+      nss[i] = static_cast<double>(ns) / static_cast<double>(keyCount);
+      if (found == 0) {
+        printf("(nothing found)\n");
+      }
+    }
+    return std::pair<double, double>(nss[0], nss[1]);
+  };
+  auto [filterHitNs, filterMissNs] = time([&] (const HashWrapper<u8string> &key) {
+    return filter.mayContain(key);
+  });
+  printf("%-24s %12.2f %12.2f\n", "BloomFilter", filterHitNs, filterMissNs);
+  auto [setHitNs, setMissNs] = time([&] (const HashWrapper<u8string> &key) {
+    return set.contains(key);
+  });
+  printf("%-24s %12.2f %12.2f\n", "FlatHashSet", setHitNs, setMissNs);
+  printf(
+    "BloomFilter: %zu octets (%.2f bits per key); false positive rate %.4f (expected %.4f)\n",
+    filter.getSize(), static_cast<double>(filter.getSize() * 8) / static_cast<double>(keyCount),
+    static_cast<double>(getFalsePositiveCount(filter, keyCount, keyCount * 2)) / static_cast<double>(keyCount),
+    filter.getFalsePositiveRate(keyCount)
+  );
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
@@ -0,0 +1,166 @@
+#include "header.hpp"
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <unordered_set>
+#include <algorithm>
+
+using core::check;
+using core::hash;
+using core::RollingHash;
+using core::Chunker;
+using std::unordered_set;
+using std::vector;
+using std::deque;
+using std::min;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+vector<iu8f> createOctets (size_t size, iu64f seed) {
+  vector<iu8f> octets(size);
+  Random(seed).fill(octets.data(), octets.data() + size);
+  return octets;
+}
+
+vector<Chunker::Chunk> chunk (const vector<iu8f> &octets, size_t pieceSize) {
+  Chunker chunker(1024, 4096, 16384);
+  vector<Chunker::Chunk> chunks;
+  for (size_t i = 0; i != octets.size();) {
+    size_t end = min(octets.size(), i + pieceSize);
+    const iu8f *ptr = octets.data() + i;
+    const iu8f *ptrEnd = octets.data() + end;
+    while (chunker.update(ptr, ptrEnd)) {
+      chunks.push_back(chunker.takeChunk());
+    }
+    check(ptrEnd == ptr);
+    i = end;
+  }
+  if (chunker.getSize() != 0) {
+    chunks.push_back(chunker.takeChunk());
+  }
+  return chunks;
+}
+
+}
+
+void testRollingHash () {
+  vector<iu8f> octets = createOctets(4000, 1);
+  // Repeat a stretch, so that equal windows come after different octets.
+  std::copy(octets.begin() + 100, octets.begin() + 300, octets.begin() + 2000);
+
+  for (size_t windowSize : {1U, 16U, 48U, 64U, 100U}) {
+    RollingHash rolling(windowSize);
+    for (size_t i = 0; i != windowSize; ++i) {
+      rolling.push(octets[i]);
+    }
+    for (size_t i = windowSize; i != octets.size(); ++i) {
+      rolling.roll(octets[i - windowSize], octets[i]);
+
+      RollingHash fresh(windowSize);
+      for (size_t j = i + 1 - windowSize; j != i + 1; ++j) {
+        fresh.push(octets[j]);
+      }
+      check(fresh.get(), rolling.get());
+    }
+  }
+
+  RollingHash h0(32), h1(32);
+  for (size_t i = 0; i != 32; ++i) {
+    h0.push(octets[100 + i]);
+    h1.push(octets[2000 + i]);
+  }
+  check(h0.get(), h1.get());
+  h1.roll(octets[2000], 0);
+  check(h0.get() != h1.get());
+}
+
+void testChunker () {
+  vector<iu8f> octets = createOctets(1 << 20, 2);
+
+  // Check that the chunks cover the octets, are within the sizes and have
+  // fingerprints that are their hash values.
+  vector<Chunker::Chunk> chunks = chunk(octets, octets.size());
+  size_t offset = 0;
+  for (size_t i = 0; i != chunks.size(); ++i) {
+    const Chunker::Chunk &c = chunks[i];
+    check(c.size <= 16384);
+    check(c.size >= 1024 || i + 1 == chunks.size());
+    check(hash(octets.data() + offset, octets.data() + offset + c.size), c.h);
+    offset += c.size;
+  }
+  check(octets.size(), offset);
+  size_t averageSize = octets.size() / chunks.size();
+  check(averageSize > 2048 && averageSize < 8192);
+
+  // Check that the boundaries don't depend on how the octets are supplied.
+  for (size_t pieceSize : {1U, 7U, 1000U, 5000U}) {
+    vector<Chunker::Chunk> pieceChunks = chunk(octets, pieceSize);
+    check(chunks.size(), pieceChunks.size());
+    for (size_t i = 0; i != chunks.size(); ++i) {
+      check(chunks[i].size, pieceChunks[i].size);
+      check(chunks[i].h, pieceChunks[i].h);
+    }
+  }
+  deque<iu8f> octetDeque(octets.begin(), octets.end());
+  Chunker chunker(1024, 4096, 16384);
+  auto ptr = octetDeque.cbegin();
+  for (const Chunker::Chunk &c : chunks) {
+    check(chunker.update(ptr, octetDeque.cend()) || ptr == octetDeque.cend());
+    Chunker::Chunk dequeC = chunker.takeChunk();
+    check(c.size, dequeC.size);
+    check(c.h, dequeC.h);
+  }
+
+  // Check that an insertion changes only the chunks around it.
+  vector<iu8f> editedOctets(octets);
+  vector<iu8f> insertion = createOctets(100, 3);
+  editedOctets.insert(editedOctets.begin() + 500000, insertion.begin(), insertion.end());
+  vector<Chunker::Chunk> editedChunks = chunk(editedOctets, editedOctets.size());
+  unordered_set<size_t> fingerprints;
+  for (const Chunker::Chunk &c : chunks) {
+    fingerprints.insert(c.h);
+  }
+  size_t sharedCount = 0;
+  for (const Chunker::Chunk &c : editedChunks) {
+    sharedCount += fingerprints.contains(c.h);
+  }
+  check(sharedCount + 3 >= chunks.size());
+
+  // Check that the maximum size holds where the content gives no boundaries.
+  vector<iu8f> zeroes(100000, 0);
+  for (const Chunker::Chunk &c : chunk(zeroes, zeroes.size())) {
+    check(c.size <= 16384);
+  }
+}
+
+void benchmarkChunker () {
+  typedef std::chrono::steady_clock Clock;
+  vector<iu8f> octets = createOctets(256 << 20, 4);
+  for (int pass = 0; pass != 3; ++pass) {
+    auto start = Clock::now();
+    vector<Chunker::Chunk> chunks = chunk(octets, octets.size());
+    double s = std::chrono::duration<double>(Clock::now() - start).count();
+    printf(
+      "Chunker (4 KiB average): %.2f GB/s, %zu chunks averaging %zu octets\n",
+      static_cast<double>(octets.size()) / s / 1e9, chunks.size(), octets.size() / chunks.size()
+    );
+  }
+
+  auto start = Clock::now();
+  RollingHash rolling(48);
+  size_t acc = 0;
+  for (size_t i = 0; i != 48; ++i) {
+    rolling.push(octets[i]);
+  }
+  for (size_t i = 48; i != octets.size(); ++i) {
+    rolling.roll(octets[i - 48], octets[i]);
+    acc += rolling.get() >> 63;
+  }
+  double s = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("RollingHash (48-octet window): %.2f GB/s (%zu)\n", static_cast<double>(octets.size()) / s / 1e9, acc);
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
@@ -0,0 +1,181 @@
+#include "header.hpp"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+
+using core::check;
+using core::writeDeltaSequence;
+using core::DeltaSequenceReader;
+using core::PlainException;
+using std::vector;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+// Creates values in ascending order with gaps of up to maxGap (or, if maxGap
+// is 0, values of all sizes in no order).
+template<typename _i> vector<_i> createValues (size_t count, iu64f maxGap, Random &r_random) {
+  vector<_i> values;
+  auto value = static_cast<_i>(maxGap == 0 ? 0 : core::numeric_limits<_i>::min());
+  for (size_t n = 0; n != count; ++n) {
+    if (maxGap == 0) {
+      value = static_cast<_i>(r_random.nextOfAnySize());
+    } else {
+      value = static_cast<_i>(value + static_cast<_i>(r_random.next() % (maxGap + 1)));
+    }
+    values.push_back(value);
+  }
+  return values;
+}
+
+template<typename _i> void testValues (const vector<_i> &values) {
+  constexpr size_t blockSize = DeltaSequenceReader<_i>::blockSize;
+  vector<iu8f> octets{0xAB};
+  writeDeltaSequence(octets, values.data(), values.size());
+  check(0xAB, octets[0]);
+  const iu8f *ptr = octets.data() + 1;
+  const iu8f *ptrEnd = octets.data() + octets.size();
+
+  // Check reading the whole sequence, and a block at a time.
+  DeltaSequenceReader<_i> reader(ptr, ptrEnd);
+  check(values.size(), reader.size());
+  vector<_i> decoded(values.size());
+  reader.readAll(decoded.data());
+  check(values.begin(), values.end(), decoded.begin(), decoded.end());
+  check(ptrEnd == reader.getPtr());
+  check(values.size(), reader.getIndex());
+
+  DeltaSequenceReader<_i> blockReader(ptr, ptrEnd);
+  _i block[blockSize];
+  for (size_t i = 0; i != values.size();) {
+    check(i, blockReader.getIndex());
+    size_t blockCount = blockReader.readBlock(block);
+    check(std::min(blockSize, values.size() - i), blockCount);
+    check(values.begin() + static_cast<ptrdiff_t>(i), values.begin() + static_cast<ptrdiff_t>(i + blockCount), block, block + blockCount);
+    i += blockCount;
+  }
+  check(0U, blockReader.readBlock(block));
+  check(!blockReader.skipBlock());
+
+  core::string<iu8f> octetString;
+  writeDeltaSequence(octetString, values.data(), values.size());
+  check(octets.begin() + 1, octets.end(), octetString.begin(), octetString.end());
+
+  // Check skipping to indices.
+  for (size_t index : {0UL, 1UL, blockSize - 1, blockSize, blockSize * 3 + 5, values.size() / 2, values.size()}) {
+    DeltaSequenceReader<_i> indexReader(ptr, ptrEnd);
+    indexReader.skipToIndex(index);
+    if (index >= values.size()) {
+      check(indexReader.getIndex() <= values.size());
+      continue;
+    }
+    size_t blockIndex = indexReader.getIndex();
+    check(blockIndex <= index && index < blockIndex + blockSize);
+    indexReader.readBlock(block);
+    check(values[index], block[index - blockIndex]);
+  }
+
+  // Check that truncation is noticed.
+  for (size_t size = 1; size < octets.size(); size += 1 + size / 4) {
+    bool truncated = false;
+    try {
+      DeltaSequenceReader<_i> truncatedReader(ptr, octets.data() + size);
+      truncatedReader.readAll(decoded.data());
+    } catch (const PlainException &) {
+      truncated = true;
+    }
+    check(truncated);
+  }
+}
+
+template<typename _i> void testSkippingToValues (const vector<_i> &values) {
+  constexpr size_t blockSize = DeltaSequenceReader<_i>::blockSize;
+  vector<iu8f> octets;
+  writeDeltaSequence(octets, values.data(), values.size());
+  Random random(5);
+  for (size_t n = 0; n != 200; ++n) {
+    _i target = n == 0 ? values.front() : n == 1 ? values.back() : values[random.next() % values.size()];
+    target = static_cast<_i>(target + static_cast<_i>(n % 3 == 0));
+    auto lowerBound = static_cast<size_t>(std::lower_bound(values.begin(), values.end(), target) - values.begin());
+    DeltaSequenceReader<_i> reader(octets.data(), octets.data() + octets.size());
+    reader.skipToValue(target);
+    check(reader.getIndex() <= lowerBound);
+    check(lowerBound == values.size() || lowerBound < reader.getIndex() + blockSize * 2);
+  }
+}
+
+template<typename _i> void testDeltaSequenceType () {
+  Random random(1);
+  for (size_t count : {0U, 1U, 2U, 127U, 128U, 129U, 1000U}) {
+    for (iu64f maxGap : {0U, 1U, 10U, 1000U}) {
+      testValues(createValues<_i>(count, maxGap, random));
+    }
+  }
+  if constexpr (sizeof(_i) >= 2) {
+    testSkippingToValues(createValues<_i>(5000, 10, random));
+  }
+}
+
+}
+
+void testDeltaSequence () {
+  testDeltaSequenceType<iu32f>();
+  testDeltaSequenceType<is32f>();
+  testDeltaSequenceType<iu64f>();
+  testDeltaSequenceType<is64f>();
+  testDeltaSequenceType<iu16f>();
+  testDeltaSequenceType<signed char>();
+
+  // Check that sorted values with small gaps take about an octet each.
+  Random random(2);
+  vector<iu32f> values = createValues<iu32f>(10000, 60, random);
+  vector<iu8f> octets;
+  writeDeltaSequence(octets, values.data(), values.size());
+  check(octets.size() < values.size() * 11 / 10);
+}
+
+void benchmarkDeltaSequence () {
+  typedef std::chrono::steady_clock Clock;
+  Random random(3);
+  const size_t count = 1 << 22;
+  for (iu64f maxGap : {4U, 100U, 10000U}) {
+    vector<iu32f> values = createValues<iu32f>(count, maxGap, random);
+    vector<iu8f> ieOctets;
+    auto out = std::back_inserter(ieOctets);
+    for (iu32f value : values) {
+      core::writeIeu(out, value);
+    }
+    vector<iu8f> octets;
+    writeDeltaSequence(octets, values.data(), values.size());
+
+    vector<iu32f> decoded(count);
+    double nss[2];
+    for (size_t i = 0; i != 2; ++i) {
+      auto start = Clock::now();
+      if (i == 0) {
+        const iu8f *ptr = ieOctets.data();
+        const iu8f *ptrEnd = ptr + ieOctets.size();
+        for (size_t n = 0; n != count; ++n) {
+          decoded[n] = core::readIeu<iu32f>(ptr, ptrEnd);
+        }
+      } else {
+        DeltaSequenceReader<iu32f> reader(octets.data(), octets.data() + octets.size());
+        reader.readAll(decoded.data());
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+      nss[i] = static_cast<double>(ns) / static_cast<double>(count);
+      check(values.begin(), values.end(), decoded.begin(), decoded.end());
+    }
+    printf(
+      "sorted iu32fs (gaps up to %5lu): readIeu %.2f octets, %.2f ns; DeltaSequenceReader %.2f octets, %.2f ns per value\n",
+      maxGap,
+      static_cast<double>(ieOctets.size()) / static_cast<double>(count), nss[0],
+      static_cast<double>(octets.size()) / static_cast<double>(count), nss[1]
+    );
+  }
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
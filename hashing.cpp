@@ -1,19 +1,170 @@
 #include "header.hpp"
 #include <algorithm>
 #include <unordered_set>
+#include <cstring>
+#include <array>
+#include <tuple>
+#include <utility>
+#include <string>
 
 using core::check;
 using core::HashWrapper;
 using std::move;
 using core::hashed;
+using core::hashFast;
 using std::min;
 using std::vector;
 using std::unordered_set;
 using std::reference_wrapper;
 using std::ref;
+using core::hash;
+using core::HashKernel;
+using core::isHashKernelSupported;
+using core::setHashKernel;
+using core::getHashKernel;
+using core::Hasher;
+using core::u8string;
+using core::HashKey;
+using core::getProcessHashKey;
+using core::mixHash;
+using core::hashBatch;
+using core::hashedBatch;
+using core::HashedLiteral;
+using core::hashedLiteral;
+using core::HashedView;
+using core::hashedView;
+using core::FlatHashSet;
+using core::ConcurrentHashMap;
+using core::combineHashes;
+using core::CompactHashWrapper;
+using core::compactHashed;
+using core::PrecomputedHash;
+using core::hashSlow;
+using core::HashingString;
+using std::pair;
+using std::tuple;
 
 /* -----------------------------------------------------------------------------
 ----------------------------------------------------------------------------- */
+void testHash () {
+  iu8f b[2048];
+  for (size_t i = 0; i != sizeof(b); ++i) {
+    b[i] = static_cast<iu8f>(i * 7 + (i >> 8));
+  }
+
+  // Check that every length (over all of the paths through the engine) gives a
+  // distinct value and that the value depends only on the octets (rather than
+  // where they are).
+  unordered_set<size_t> hs;
+  vector<iu8f> c(sizeof(b) + 16);
+  for (size_t size = 0; size != sizeof(b); ++size) {
+    size_t h = hash(b, b + size);
+    check(hs.insert(h).second);
+    for (size_t o = 1; o < 16; o += 5) {
+      memcpy(c.data() + o, b, size);
+      check(h, hash(c.data() + o, c.data() + o + size));
+    }
+  }
+
+  // Check that every single-bit change gives a different value.
+  for (size_t size = 1; size <= 300; size += (size < 40 ? 1 : 37)) {
+    size_t h = hash(b, b + size);
+    hs.clear();
+    for (size_t i = 0; i != size * 8; ++i) {
+      b[i / 8] ^= static_cast<iu8f>(1 << (i % 8));
+      size_t flippedH = hash(b, b + size);
+      b[i / 8] ^= static_cast<iu8f>(1 << (i % 8));
+      check(h != flippedH);
+      check(hs.insert(flippedH).second);
+    }
+  }
+
+  // Check that every kernel supported here gives the same values.
+  HashKernel originalKernel = getHashKernel();
+  check(isHashKernelSupported(originalKernel));
+  check(isHashKernelSupported(HashKernel::scalar));
+  check(setHashKernel(HashKernel::scalar));
+  check(HashKernel::scalar, getHashKernel());
+  vector<size_t> expectedHs;
+  for (size_t size = 0; size != sizeof(b); ++size) {
+    expectedHs.push_back(hash(b, b + size));
+  }
+  for (HashKernel kernel : {HashKernel::sse2, HashKernel::avx2}) {
+    if (!isHashKernelSupported(kernel)) {
+      check(!setHashKernel(kernel));
+      continue;
+    }
+    check(setHashKernel(kernel));
+    check(kernel, getHashKernel());
+    for (size_t size = 0; size != sizeof(b); ++size) {
+      check(expectedHs[size], hash(b, b + size));
+    }
+  }
+  check(setHashKernel(originalKernel));
+}
+
+class StreamablyHashableThing {
+  prv u8string a;
+  prv int b;
+
+  pub StreamablyHashableThing (const char8_t *a, int b) : a(a), b(b) {
+  }
+
+  pub void hashSlow (Hasher &r_hasher) const noexcept {
+    r_hasher.update(a);
+    r_hasher.update(b);
+  }
+
+  pub bool operator== (const StreamablyHashableThing &r) const noexcept {
+    return a == r.a && b == r.b;
+  }
+};
+
+void testHasher () {
+  iu8f b[5000];
+  for (size_t i = 0; i != sizeof(b); ++i) {
+    b[i] = static_cast<iu8f>(i * 13 + (i >> 7));
+  }
+
+  // Check that, however the input is split up, the value is that of hash().
+  iu32f rnd = 1;
+  for (size_t size = 0; size < sizeof(b); size += (size < 1100 ? 1 : 97)) {
+    size_t expectedH = hash(b, b + size);
+    for (size_t pieceSizeLimit : {1U, 7U, 31U, 32U, 33U, 200U, 300U, 1000U}) {
+      Hasher hasher;
+      for (size_t i = 0; i != size;) {
+        rnd = rnd * 1103515245 + 12345;
+        size_t pieceSize = min(size - i, static_cast<size_t>(rnd >> 16) % pieceSizeLimit + 1);
+        hasher.update(b + i, b + i + pieceSize);
+        i += pieceSize;
+      }
+      check(expectedH, hasher.finish());
+      check(expectedH, hasher.finish());
+    }
+  }
+
+  // Check that integers are fed in little-endian order.
+  Hasher hasher;
+  hasher.update(static_cast<iu32f>(0x04030201));
+  hasher.update(static_cast<is8f>(-1));
+  hasher.update(static_cast<iu64f>(0x0C0B0A0908070605));
+  const iu8f e[] = {1, 2, 3, 4, 0xFF, 5, 6, 7, 8, 9, 10, 11, 12};
+  check(hash(e, e + sizeof(e)), hasher.finish());
+
+  // Check that composite objects can feed their members straight in.
+  hasher = Hasher();
+  hasher.update(u8string(u8"abc"));
+  hasher.update(7);
+  check(hasher.finish(), core::hashSlow(StreamablyHashableThing(u8"abc", 7)));
+  check(core::hashSlow(StreamablyHashableThing(u8"ab", 7)) != core::hashSlow(StreamablyHashableThing(u8"abc", 7)));
+  check(core::hashSlow(StreamablyHashableThing(u8"abc", 6)) != core::hashSlow(StreamablyHashableThing(u8"abc", 7)));
+  check(noexcept(HashWrapper<StreamablyHashableThing>(u8"abc", 7)) == false);
+  unordered_set<HashWrapper<StreamablyHashableThing>> s;
+  s.emplace(u8"abc", 7);
+  check(s.find(HashWrapper<StreamablyHashableThing>(u8"abc", 7)) != s.end());
+  check(s.find(HashWrapper<StreamablyHashableThing>(u8"abc", 8)) == s.end());
+}
+
 size_t cCons0, cCons1, cCons2, cConsCopy, cConsMove, cHash, cEq;
 
 void r () {
@@ -429,6 +580,230 @@ template<typename _Referent, bool _noexceptHash, bool _noexceptEq, bool _cachedH
   check(s.find(hashed(ref(v1))) != s.end());
 }
 
+void testKeyedHashing () {
+  iu8f b[1000];
+  for (size_t i = 0; i != sizeof(b); ++i) {
+    b[i] = static_cast<iu8f>(i * 5 + (i >> 6));
+  }
+
+  HashKey unkeyed, key0(0), key1(1), key1Again(1);
+  for (size_t size = 0; size < sizeof(b); size += (size < 140 ? 1 : 29)) {
+    size_t h = hash(b, b + size);
+    check(h, hash(b, b + size, unkeyed));
+    size_t h0 = hash(b, b + size, key0);
+    size_t h1 = hash(b, b + size, key1);
+    check(h != h0);
+    check(h != h1);
+    check(h0 != h1);
+    check(h1, hash(b, b + size, key1Again));
+
+    Hasher hasher(key1);
+    for (size_t i = 0; i != size; i += min(size - i, static_cast<size_t>(45))) {
+      hasher.update(b + i, b + i + min(size - i, static_cast<size_t>(45)));
+    }
+    check(h1, hasher.finish());
+  }
+
+  check(&getProcessHashKey() == &getProcessHashKey());
+  unordered_set<size_t> hs;
+  for (size_t h = 0; h != 1000; ++h) {
+    check(mixHash(h, key0), mixHash(h, key0));
+    check(hs.insert(mixHash(h, key0)).second);
+  }
+  check(mixHash(1, key0) != mixHash(1, key1));
+
+  u8string k(u8"key");
+  HashWrapper<u8string, true> o0(k);
+  check(core::hashSlow(k, getProcessHashKey()), o0.hashFast());
+  check(hash(reinterpret_cast<const iu8f *>(k.data()), reinterpret_cast<const iu8f *>(k.data() + k.size()), key1), core::hashSlow(k, key1));
+  check(core::hashSlow(ref(k), getProcessHashKey()), o0.hashFast());
+  check(hashed<true>(u8string(k)) == o0);
+  check(!(hashed<true>(u8string(u8"kez")) == o0));
+  unordered_set<HashWrapper<u8string, true>> s;
+  s.emplace(u8"key");
+  check(s.find(o0) != s.end());
+  check(s.find(HashWrapper<u8string, true>(u8"kex")) == s.end());
+
+  HashWrapper<QuicklyHashableThing, true> o1(4);
+  check(mixHash(hashFast(QuicklyHashableThing(4)), getProcessHashKey()), o1.hashFast());
+  check(std::hash<HashWrapper<QuicklyHashableThing, true>>()(o1), o1.hashFast());
+  check(o1 == HashWrapper<QuicklyHashableThing, true>(4));
+}
+
+void testHashBatch () {
+  iu8f b[3000];
+  for (size_t i = 0; i != sizeof(b); ++i) {
+    b[i] = static_cast<iu8f>(i * 11 + (i >> 5));
+  }
+
+  // Check that, whatever mix of lengths is in each group, every value is that of
+  // hash().
+  const size_t count = 1000;
+  vector<const iu8f *> is, ends;
+  iu32f rnd = 7;
+  for (size_t n = 0; n != count; ++n) {
+    rnd = rnd * 1103515245 + 12345;
+    size_t size = (rnd >> 16) % (n % 3 == 0 ? 600 : 140);
+    size_t o = (rnd >> 8) % 64;
+    is.push_back(b + o);
+    ends.push_back(b + o + size);
+  }
+  HashKey key(77);
+  const size_t batchCounts[] = {0, 1, 3, 4, 5, 17, count};
+  for (size_t batchCount : batchCounts) {
+    vector<size_t> hs(batchCount + 1, 0);
+    hashBatch(is.data(), ends.data(), batchCount, hs.data());
+    for (size_t n = 0; n != batchCount; ++n) {
+      check(hash(is[n], ends[n]), hs[n]);
+    }
+    check(0U, hs[batchCount]);
+
+    hashBatch(is.data(), ends.data(), batchCount, hs.data(), key);
+    for (size_t n = 0; n != batchCount; ++n) {
+      check(hash(is[n], ends[n], key), hs[n]);
+    }
+  }
+
+  vector<u8string> ss;
+  for (size_t n = 0; n != 100; ++n) {
+    ss.emplace_back(n * 3, static_cast<char8_t>(u8'a' + n % 26));
+  }
+  vector<u8string> ssCopy(ss);
+  vector<HashWrapper<u8string>> os;
+  auto osI = std::back_inserter(os);
+  hashedBatch(ss.begin(), ss.end(), osI);
+  check(ssCopy.size(), os.size());
+  for (size_t n = 0; n != ssCopy.size(); ++n) {
+    check(ssCopy[n], os[n].get());
+    check(hashed(u8string(ssCopy[n])).hashFast(), os[n].hashFast());
+  }
+
+  vector<HashWrapper<u8string, true>> keyedOs;
+  auto keyedOsI = std::back_inserter(keyedOs);
+  hashedBatch<true>(ssCopy.begin(), ssCopy.end(), keyedOsI);
+  check(ss.size(), keyedOs.size());
+  for (size_t n = 0; n != keyedOs.size(); ++n) {
+    check(hashed<true>(u8string(os[n].get())).hashFast(), keyedOs[n].hashFast());
+  }
+}
+
+// The sizes at which to compare values computed at compile time against those
+// computed at run time, covering every path through the engine (including
+// scrambling at the end of a block and a partial final stripe).
+constexpr size_t constantHashSizes[] = {
+  0, 1, 2, 3, 4, 5, 7, 8, 9, 12, 15, 16, 17, 31, 32, 33, 48, 64, 100, 127, 128, 129, 130, 160, 161, 255, 256, 257,
+  511, 512, 513, 544, 545, 1000, 1023, 1024, 1025, 1100
+};
+
+constexpr iu8f getConstantHashOctet (size_t i) {
+  return static_cast<iu8f>(i * 13 + (i >> 7));
+}
+
+constexpr std::array<size_t, sizeof(constantHashSizes) / sizeof(*constantHashSizes)> getConstantHashes () {
+  iu8f b[1100] = {};
+  for (size_t i = 0; i != sizeof(b); ++i) {
+    b[i] = getConstantHashOctet(i);
+  }
+  std::array<size_t, sizeof(constantHashSizes) / sizeof(*constantHashSizes)> hs = {};
+  for (size_t n = 0; n != hs.size(); ++n) {
+    hs[n] = hash(b, b + constantHashSizes[n]);
+  }
+  return hs;
+}
+
+void testConstantHashing () {
+  constexpr auto constantHs = getConstantHashes();
+  iu8f b[1100];
+  for (size_t i = 0; i != sizeof(b); ++i) {
+    b[i] = getConstantHashOctet(i);
+  }
+  HashKernel originalKernel = getHashKernel();
+  for (iu k = 0; k != 3; ++k) {
+    if (!setHashKernel(static_cast<HashKernel>(k))) {
+      continue;
+    }
+    for (size_t n = 0; n != constantHs.size(); ++n) {
+      check(constantHs[n], hash(b, b + constantHashSizes[n]));
+    }
+  }
+  check(setHashKernel(originalKernel));
+
+  constexpr const char8_t *s = u8"constant key";
+  constexpr size_t sH = hash(s, s + 12);
+  check(sH, hash(reinterpret_cast<const iu8f *>(s), reinterpret_cast<const iu8f *>(s) + 12));
+  static constexpr char text[] = "text";
+  static_assert(hash(text, text + 4) == hash(u8"text", u8"text" + 4));
+
+  constexpr HashedLiteral<char8_t> l = hashedLiteral(u8"constant key");
+  static_assert(l.hashFast() == sH);
+  static_assert(l.end() - l.begin() == 12);
+  HashWrapper<u8string> o = l;
+  check(u8string(u8"constant key"), o.get());
+  check(hashed(u8string(u8"constant key")).hashFast(), o.hashFast());
+  check(hashFast(l), o.hashFast());
+
+  unordered_set<HashWrapper<u8string>> set;
+  set.emplace(u8"constant key");
+  set.emplace(u8"other key");
+  check(set.find(l) != set.end());
+  check(set.find(hashedLiteral(u8"missing key")) == set.end());
+}
+
+void testHashedView () {
+  const char8_t *chars = u8"some key and more";
+  HashedView<char8_t> v(chars, chars + 8);
+  check(static_cast<size_t>(8), v.size());
+  check(hashed(u8string(u8"some key")).hashFast(), v.hashFast());
+  check(hashedView(u8"some key").hashFast(), v.hashFast());
+  check(hashedView(u8string(u8"some key")).hashFast(), v.hashFast());
+  check(HashedView<char8_t>(hashedLiteral(u8"some key")).hashFast(), v.hashFast());
+  check(v == hashed(u8string(u8"some key")));
+  check(hashed(u8string(u8"some key")) == v);
+  check(!(v == hashed(u8string(u8"some kex"))));
+  check(!(v == hashed(u8string(u8"some key "))));
+  check(hashedView(u8"") == hashed(u8string()));
+
+  HashedView<char8_t, true> keyedV = hashedView<true>(chars, chars + 8);
+  check(hashed<true>(u8string(u8"some key")).hashFast(), keyedV.hashFast());
+  check(keyedV == hashed<true>(u8string(u8"some key")));
+
+  unordered_set<HashWrapper<u8string>, std::hash<HashWrapper<u8string>>, std::equal_to<>> set;
+  set.emplace(u8"some key");
+  set.emplace(u8"other key");
+  check(set.find(v) != set.end());
+  check(set.find(hashedView(u8"other key"))->get() == u8string(u8"other key"));
+  check(set.find(hashedView(u8"missing key")) == set.end());
+  check(set.find(hashedLiteral(u8"other key")) != set.end());
+  check(set.find(hashedLiteral(u8"missing key")) == set.end());
+
+  FlatHashSet<HashWrapper<u8string>> flatSet;
+  flatSet.emplace(u8"some key");
+  flatSet.emplace(u8"other key");
+  check(flatSet.find(v) != flatSet.end());
+  check(flatSet.contains(hashedLiteral(u8"other key")));
+  check(!flatSet.contains(hashedView(u8"missing key")));
+  check(static_cast<size_t>(1), flatSet.erase(v));
+  check(!flatSet.contains(v));
+  check(static_cast<size_t>(0), flatSet.erase(v));
+  check(static_cast<size_t>(1), flatSet.size());
+
+  FlatHashSet<HashWrapper<u8string, true>> keyedSet;
+  keyedSet.emplace(u8"some key");
+  check(keyedSet.contains(keyedV));
+  check(!keyedSet.contains(hashedView<true>(u8"some kex")));
+
+  ConcurrentHashMap<HashWrapper<u8string>, int> map;
+  map.try_emplace(hashed(u8string(u8"some key")), 3);
+  check(map.contains(v));
+  check(3, *map.get(v));
+  check(!map.get(hashedLiteral(u8"missing key")));
+  int seen = 0;
+  check(map.visit(v, [&] (const int &value) {
+    seen = value;
+  }));
+  check(3, seen);
+}
+
 void testHashing () {
   testValueHashing<SlowlyHashableThing, true, true, true, true>();
   testValueHashing<SlowlyHashableExceptingHashThing, false, true, true, true>();
@@ -453,5 +828,178 @@ void testHashing () {
   check(sizeof(HashWrapper<reference_wrapper<QuicklyHashableThing>>) == sizeof(HashWrapper<reference_wrapper<QuicklyHashableExceptingEqThing>>));
 }
 
+// A small key with tail padding (which, not being POD, its users may reuse).
+class PaddedThing {
+  prv iu64f a;
+  prv iu32f b;
+
+  pub PaddedThing (iu64f a, iu32f b) noexcept : a(a), b(b) {
+  }
+
+  pub size_t hashSlow () const noexcept {
+    iu8f octets[12];
+    for (iu i = 0; i != 8; ++i) {
+      octets[i] = static_cast<iu8f>(a >> (i * 8));
+    }
+    for (iu i = 0; i != 4; ++i) {
+      octets[8 + i] = static_cast<iu8f>(b >> (i * 8));
+    }
+    return hash(octets, octets + 12);
+  }
+
+  pub size_t hashSlow (const HashKey &key) const noexcept {
+    return mixHash(hashSlow(), key);
+  }
+
+  pub bool operator== (const PaddedThing &r) const noexcept {
+    return a == r.a && b == r.b;
+  }
+};
+
+void testCompactHashWrapper () {
+  // (A string has no tail padding, and its alignment rounds 36 up to 40.)
+  check(sizeof(CompactHashWrapper<u8string>) <= sizeof(HashWrapper<u8string>));
+  check(sizeof(CompactHashWrapper<PaddedThing>) < sizeof(HashWrapper<PaddedThing>));
+  #if defined(__GNUC__) && !defined(_WIN32)
+  check(sizeof(PaddedThing), sizeof(CompactHashWrapper<PaddedThing>));
+  #endif
+
+  CompactHashWrapper<u8string> w(u8"abc");
+  check(u8string(u8"abc"), w.get());
+  check(w == compactHashed(u8string(u8"abc")));
+  check(!(w == compactHashed(u8string(u8"abd"))));
+  check(w.hashFast() != compactHashed(u8string(u8"abd")).hashFast());
+  check(w.hashFast(), CompactHashWrapper<u8string>(PrecomputedHash{hashed(u8string(u8"abc")).hashFast()}, u8"abc").hashFast());
+  check(compactHashed<true>(u8string(u8"abc")).hashFast() != w.hashFast());
+  check(u8string(u8"abc"), std::move(w).release());
+
+  // The widened values should vary in both their low and their high bits.
+  size_t orLow = 0, andLow = ~static_cast<size_t>(0), orHigh = 0, andHigh = ~static_cast<size_t>(0);
+  for (iu32f n = 0; n != 64; ++n) {
+    size_t h = CompactHashWrapper<PaddedThing>(n, n).hashFast();
+    orLow |= h & 0xFFFF;
+    andLow &= h & 0xFFFF;
+    orHigh |= h >> 48;
+    andHigh &= h >> 48;
+  }
+  check(static_cast<size_t>(0xFFFF), orLow);
+  check(static_cast<size_t>(0), andLow);
+  check(static_cast<size_t>(0xFFFF), orHigh);
+  check(static_cast<size_t>(0), andHigh);
+
+  unordered_set<CompactHashWrapper<PaddedThing>> set;
+  FlatHashSet<CompactHashWrapper<PaddedThing, true>> flatSet;
+  for (iu32f n = 0; n != 1000; ++n) {
+    set.emplace(n, n * 3);
+    flatSet.emplace(n, n * 3);
+  }
+  for (iu32f n = 0; n != 1000; ++n) {
+    check(set.contains(CompactHashWrapper<PaddedThing>(n, n * 3)));
+    check(!set.contains(CompactHashWrapper<PaddedThing>(n, n * 3 + 1)));
+    check(flatSet.contains(CompactHashWrapper<PaddedThing, true>(n, n * 3)));
+  }
+}
+
+void testCompositeHashing () {
+  // Combining depends on the order and keeps distinct values distinct.
+  check(combineHashes(combineHashes(0, 1), 2) != combineHashes(combineHashes(0, 2), 1));
+  check(combineHashes(5, 1) != combineHashes(5, 2));
+
+  typedef pair<u8string, iu32> P;
+  check(core::SlowHashable<P>);
+  check(core::KeyedSlowHashable<P>);
+  P p(u8"a", 1);
+  check(noexcept(hashSlow(p)));
+  check(hashSlow(p), hashSlow(P(u8"a", 1)));
+  check(hashSlow(P(u8"a", 1)) != hashSlow(P(u8"a", 2)));
+  check(hashSlow(P(u8"a", 1)) != hashSlow(P(u8"b", 1)));
+  check(hashSlow(P(u8"a", 1), getProcessHashKey()) != hashSlow(P(u8"a", 1)));
+  check(hashSlow(P(u8"a", 1), getProcessHashKey()), hashed<true>(P(u8"a", 1)).hashFast());
+  check(hashSlow(P(u8"a", 1)), hashSlow(tuple<u8string, iu32>(u8"a", 1)));
+  check(hashSlow(tuple<int, int, int>(1, 2, 3)) != hashSlow(tuple<int, int, int>(3, 2, 1)));
+  check(hashSlow(std::tie(static_cast<const iu32 &>(7))) == hashSlow(tuple<iu32>(7)));
+
+  unordered_set<HashWrapper<P>> set;
+  set.emplace(u8"a", 1);
+  set.emplace(u8"a", 2);
+  check(set.find(hashed(P(u8"a", 2))) != set.end());
+  check(set.find(hashed(P(u8"b", 2))) == set.end());
+
+  // Ranges of integers hash as their octets; other ranges combine elements.
+  check(hashSlow(std::u8string(u8"abc")), hashSlow(u8string(u8"abc")));
+  check(hashSlow(std::string("abc")), hashed(u8string(u8"abc")).hashFast());
+  check(hashSlow(std::array<iu8f, 3>{1, 2, 3}) != hashSlow(std::array<iu8f, 3>{3, 2, 1}));
+  check(hashSlow(vector<u8string>{u8"a", u8"b"}) != hashSlow(vector<u8string>{u8"b", u8"a"}));
+  check(hashSlow(vector<u8string>{u8"a", u8"b"}), hashSlow(std::array<u8string, 2>{u8"a", u8"b"}));
+  check(hashSlow(vector<vector<u8string>>{{u8"a"}, {u8"b"}}) != hashSlow(vector<vector<u8string>>{{u8"a", u8"b"}}));
+  check(hashSlow(vector<u8string>()) != hashSlow(vector<u8string>{u8""}));
+  check(!core::SlowHashable<vector<double>>);
+  check(!core::SlowHashable<pair<u8string, double>>);
+
+  // Nested HashWrappers contribute the hash values that they cache.
+  HashWrapper<SlowlyHashableThing> thing(4);
+  r();
+  size_t h = hashSlow(pair<HashWrapper<SlowlyHashableThing>, int>(thing, 1));
+  check(h, hashSlow(tuple<const HashWrapper<SlowlyHashableThing> &, int>(thing, 1)));
+  check(static_cast<size_t>(0), cHash);
+  check(h != hashSlow(pair<HashWrapper<SlowlyHashableThing>, int>(thing, 2)));
+  tuple<SlowlyHashableExceptingHashThing, int> exceptingThing;
+  check(noexcept(hashSlow(exceptingThing)) == false);
+}
+
+void testHashingString () {
+  // Check that the value after each append is that of the whole string,
+  // however it was appended.
+  HashingString<char8_t> s;
+  u8string expected;
+  check(hashed(u8string()).hashFast(), s.hashSlow());
+  for (size_t n = 0; n != 3000; ++n) {
+    char8_t c = static_cast<char8_t>(u8'a' + n % 26);
+    switch (n % 3) {
+    case 0:
+      s.push_back(c);
+      break;
+    case 1:
+      s.append(&c, &c + 1);
+      break;
+    default:
+      *s.append_any(1) = c;
+      break;
+    }
+    expected.push_back(c);
+    check(hashed(u8string(expected)).hashFast(), s.hashSlow());
+  }
+  check(expected, s.get());
+  check(hashed(u8string(expected)).hashFast(), hashed(s).hashFast());
+  check(hashed<true>(u8string(expected)).hashFast(), hashed<true>(s).hashFast());
+
+  // Check that untracked mutations discard the hash state.
+  s.data()[0] = u8'z';
+  expected[0] = u8'z';
+  check(hashed(u8string(expected)).hashFast(), s.hashSlow());
+  s.append(u8string(u8"tail"));
+  expected.append(u8"tail");
+  check(hashed(u8string(expected)).hashFast(), s.hashSlow());
+  s.truncate(10);
+  expected.erase(10);
+  check(hashed(u8string(expected)).hashFast(), s.hashSlow());
+  s.append(u8string(u8"more"));
+  expected.append(u8"more");
+  check(hashed(u8string(expected)).hashFast(), s.hashSlow());
+  check(expected.begin(), expected.end(), s.begin(), s.end());
+
+  // Check that releasing it gives a HashWrapper that can find the string.
+  FlatHashSet<HashWrapper<u8string>> set;
+  set.insert(hashed(u8string(expected)));
+  HashWrapper<u8string> w = std::move(s).releaseHashed();
+  check(expected, w.get());
+  check(set.contains(w));
+
+  s.clear();
+  check(hashed(u8string()).hashFast(), s.hashSlow());
+  check(HashingString<char8_t>(u8string(u8"abc")) == HashingString<char8_t>(u8string(u8"abc")));
+  check(HashingString<char8_t>(u8string(u8"abc")).hashSlow(), hashed(u8string(u8"abc")).hashFast());
+}
+
 /* -----------------------------------------------------------------------------
 ----------------------------------------------------------------------------- */
@@ -0,0 +1,318 @@
+#include "header.hpp"
+#include <algorithm>
+#include <unordered_set>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+
+using core::check;
+using core::HashWrapper;
+using core::CompactHashWrapper;
+using core::FlatHashSet;
+using core::hashed;
+using core::hash;
+using core::u8string;
+using core::HashKernel;
+using core::setHashKernel;
+using core::getHashKernel;
+using std::vector;
+using std::unordered_set;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+size_t hashBytes (const vector<iu8f> &b) noexcept {
+  return hash(b.data(), b.data() + b.size());
+}
+
+// The width of core::hash()'s values (which are size_t, so not always 64 bits).
+const iu hashBitCount = std::numeric_limits<size_t>::digits;
+
+double elapsedNs (std::chrono::steady_clock::time_point start) noexcept {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The key lengths that cover each of the hash's length paths (and their
+// boundaries).
+const size_t avalancheKeySizes[] = {1, 3, 4, 8, 9, 16, 17, 64, 128, 129, 240, 1100};
+
+/**
+  Returns the worst avalanche bias of the hash over keys of {@p keySize}
+  octets: for each (input bit, output bit) pair, the probability that flipping
+  the input bit flips the output bit should be 1/2, and the bias is
+  |2p - 1| (so 0 is ideal and 1 is worst). At most {@p maxInputBitCount}
+  input bits (spread over the key) are tried.
+*/
+double getAvalancheBias (size_t keySize, size_t sampleCount, size_t maxInputBitCount) {
+  size_t bitCount = keySize * 8;
+  size_t bitStep = std::max(static_cast<size_t>(1), bitCount / maxInputBitCount);
+  size_t inputBitCount = (bitCount + bitStep - 1) / bitStep;
+  vector<iu32f> flips(inputBitCount * hashBitCount, 0);
+  vector<iu8f> b(keySize);
+  Random rnd(keySize);
+  for (size_t s = 0; s != sampleCount; ++s) {
+    rnd.fill(b.data(), b.data() + keySize);
+    size_t h = hashBytes(b);
+    for (size_t n = 0; n != inputBitCount; ++n) {
+      size_t bit = n * bitStep;
+      b[bit / 8] ^= static_cast<iu8f>(1U << (bit % 8));
+      size_t d = h ^ hashBytes(b);
+      b[bit / 8] ^= static_cast<iu8f>(1U << (bit % 8));
+      iu32f *f = flips.data() + n * hashBitCount;
+      for (iu o = 0; o != hashBitCount; ++o) {
+        f[o] += static_cast<iu32f>((d >> o) & 1);
+      }
+    }
+  }
+
+  double worst = 0.0;
+  for (iu32f f : flips) {
+    worst = std::max(worst, std::fabs(2.0 * static_cast<double>(f) / static_cast<double>(sampleCount) - 1.0));
+  }
+  return worst;
+}
+
+/**
+  Returns a bound on the worst avalanche bias that an ideal hash would be
+  (all but) certain to stay under: six standard deviations of the bias of a
+  single pair. Each flip pairs two keys, and short keys have few distinct
+  pairs, so the samples are capped accordingly.
+*/
+double getAvalancheBiasLimit (size_t keySize, size_t sampleCount) {
+  double pairCount = static_cast<double>(sampleCount);
+  if (keySize < 4) {
+    pairCount = std::min(pairCount, std::ldexp(1.0, static_cast<int>(keySize * 8 - 1)));
+  }
+  return 6.0 / std::sqrt(pairCount);
+}
+
+/**
+  Returns the number of colliding hash values (keeping only the bits selected
+  by {@p mask} of each) relative to the number expected of a random function.
+*/
+double getCollisionRatio (const vector<size_t> &hs, size_t mask) {
+  vector<size_t> masked(hs.size());
+  std::transform(hs.begin(), hs.end(), masked.begin(), [&] (size_t h) {
+    return h & mask;
+  });
+  std::sort(masked.begin(), masked.end());
+  size_t collisionCount = static_cast<size_t>(masked.end() - std::unique(masked.begin(), masked.end()));
+
+  // The expected number of collisions of n values in m buckets is
+  // n - m + m(1 - 1/m)^n.
+  double n = static_cast<double>(hs.size());
+  double m = static_cast<double>(mask) + 1.0;
+  double expected = n - m + m * std::exp(n * std::log1p(-1.0 / m));
+  return (static_cast<double>(collisionCount) + 1.0) / (expected + 1.0);
+}
+
+/**
+  Returns the worst relative deviation from the mean of the numbers of hash
+  values falling into each of 2^{@p bucketBitCount} buckets, taken from the
+  low bits (if {@p high} is false) or the high bits of the hash values,
+  measured as a chi-squared statistic over its expected value (so 1 is ideal).
+*/
+double getBucketChiSquaredRatio (const vector<size_t> &hs, iu bucketBitCount, bool high) {
+  size_t bucketCount = static_cast<size_t>(1) << bucketBitCount;
+  vector<size_t> counts(bucketCount, 0);
+  for (size_t h : hs) {
+    ++counts[static_cast<size_t>(high ? h >> (hashBitCount - bucketBitCount) : h & (bucketCount - 1))];
+  }
+
+  double expected = static_cast<double>(hs.size()) / static_cast<double>(bucketCount);
+  double chiSquared = 0.0;
+  for (size_t c : counts) {
+    double d = static_cast<double>(c) - expected;
+    chiSquared += d * d / expected;
+  }
+  return chiSquared / static_cast<double>(bucketCount - 1);
+}
+
+// Key sets that are notoriously hard on weak hashes: counters, long keys
+// of which only two bits are set, and text keys with a common prefix.
+enum class KeySet : iu {
+  counters,
+  sparse,
+  text,
+  end
+};
+
+const char *const keySetNames[] = {"counters", "sparse", "text"};
+
+vector<size_t> createKeySetHashes (KeySet keySet, size_t count) {
+  vector<size_t> hs;
+  hs.reserve(count);
+  size_t bit0 = 0;
+  size_t bit1 = 1;
+  for (size_t n = 0; n != count; ++n) {
+    switch (keySet) {
+      case KeySet::counters: {
+        iu8f b[8];
+        for (iu i = 0; i != 8; ++i) {
+          b[i] = static_cast<iu8f>(static_cast<iu64f>(n) >> (i * 8));
+        }
+        hs.push_back(hash(b, b + 8));
+        break;
+      }
+      case KeySet::sparse: {
+        // Each distinct pair of bits (bit0 < bit1) of a 288-octet key, which
+        // gives more than 2^22 keys.
+        iu8f b[288] = {};
+        b[bit0 / 8] = static_cast<iu8f>(1U << (bit0 % 8));
+        b[bit1 / 8] = static_cast<iu8f>(b[bit1 / 8] | (1U << (bit1 % 8)));
+        hs.push_back(hash(b, b + sizeof(b)));
+        if (++bit1 == sizeof(b) * 8) {
+          ++bit0;
+          bit1 = bit0 + 1;
+        }
+        break;
+      }
+      case KeySet::text: {
+        std::string s = "https://example.com/items/" + std::to_string(n);
+        auto i = reinterpret_cast<const iu8f *>(s.data());
+        hs.push_back(hash(i, i + s.size()));
+        break;
+      }
+      default:
+        check(false);
+    }
+  }
+
+  return hs;
+}
+
+// Times inserting each of the keys into a set of _S, and then finding each.
+template<typename _S> void benchmarkSet (const vector<u8string> &keys, const char *name) {
+  typedef typename _S::value_type K;
+  _S set;
+  auto start = std::chrono::steady_clock::now();
+  for (const u8string &s : keys) {
+    set.insert(K(s));
+  }
+  double insertNs = elapsedNs(start);
+  size_t found = 0;
+  start = std::chrono::steady_clock::now();
+  for (const u8string &s : keys) {
+    found += set.contains(K(s));
+  }
+  double findNs = elapsedNs(start);
+  check(keys.size(), found);
+  double keyCount = static_cast<double>(keys.size());
+  printf("%10zu %34s %6zu %12.1f %12.1f\n", keys.front().size(), name, sizeof(K), insertNs / keyCount, findNs / keyCount);
+}
+
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+void testHashAvalanche () {
+  for (size_t keySize : avalancheKeySizes) {
+    check(getAvalancheBias(keySize, 2000, 64) < getAvalancheBiasLimit(keySize, 2000));
+  }
+
+  // Only long keys go through the kernels.
+  HashKernel originalKernel = getHashKernel();
+  for (iu k = 0; k != 3; ++k) {
+    if (!setHashKernel(static_cast<HashKernel>(k))) {
+      continue;
+    }
+    for (size_t keySize : avalancheKeySizes) {
+      if (keySize > 128) {
+        check(getAvalancheBias(keySize, 2000, 64) < getAvalancheBiasLimit(keySize, 2000));
+      }
+    }
+  }
+  check(setHashKernel(originalKernel));
+}
+
+void testHashDistribution () {
+  const size_t count = 1 << 18;
+  for (iu k = 0; k != static_cast<iu>(KeySet::end); ++k) {
+    vector<size_t> hs = createKeySetHashes(static_cast<KeySet>(k), count);
+
+    // There should be no collisions of all of the bits, and a random function's
+    // share of collisions when truncated.
+    check(getCollisionRatio(hs, std::numeric_limits<size_t>::max()) < 2.0);
+    double ratio32 = getCollisionRatio(hs, 0xFFFFFFFFU);
+    check(ratio32 < 3.0);
+    double ratio16 = getCollisionRatio(hs, 0xFFFFU);
+    check(ratio16 > 0.99 && ratio16 < 1.01);
+
+    // The chi-squared statistic has a standard deviation of about
+    // sqrt(2 / 65535) ~= 0.0055 relative to its expected value.
+    for (bool high : {false, true}) {
+      double chi = getBucketChiSquaredRatio(hs, 16, high);
+      check(chi > 0.95 && chi < 1.05);
+    }
+  }
+}
+
+void benchmarkHash () {
+  // Throughput by key length: hash each length for about the same amount of
+  // time, cycling through a buffer that is bigger than the key so that the
+  // inputs vary.
+  vector<iu8f> b(2 << 20);
+  Random rnd(0);
+  rnd.fill(b.data(), b.data() + b.size());
+  printf("%10s %12s %10s\n", "key size", "ns/hash", "GB/s");
+  for (size_t keySize = 1; keySize <= (1 << 20); keySize *= 2) {
+    for (size_t size : {keySize, keySize + keySize / 2}) {
+      if (size > (1 << 20)) {
+        continue;
+      }
+      size_t iterationCount = std::max(static_cast<size_t>(64), (static_cast<size_t>(256) << 20) / (size + 16));
+      size_t window = b.size() - size;
+      size_t sum = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t n = 0; n != iterationCount; ++n) {
+        const iu8f *i = b.data() + (n * 64) % window;
+        sum += hash(i, i + size);
+      }
+      double ns = elapsedNs(start);
+      printf("%10zu %12.2f %10.2f   (%zx)\n", size, ns / static_cast<double>(iterationCount), static_cast<double>(size * iterationCount) / ns, sum & 0xF);
+    }
+  }
+
+  printf("\n%10s %14s\n", "key size", "avalanche bias");
+  for (size_t keySize : avalancheKeySizes) {
+    printf("%10zu %14.4f\n", keySize, getAvalancheBias(keySize, 10000, 256));
+  }
+
+  printf("\n%10s %12s %12s %12s %12s %12s\n", "key set", "full coll", "32b coll", "16b coll", "low chi2", "high chi2");
+  for (iu k = 0; k != static_cast<iu>(KeySet::end); ++k) {
+    vector<size_t> hs = createKeySetHashes(static_cast<KeySet>(k), 1 << 21);
+    printf(
+      "%10s %12.3f %12.3f %12.3f %12.4f %12.4f\n", keySetNames[k],
+      getCollisionRatio(hs, std::numeric_limits<size_t>::max()), getCollisionRatio(hs, 0xFFFFFFFFU), getCollisionRatio(hs, 0xFFFFU),
+      getBucketChiSquaredRatio(hs, 16, false), getBucketChiSquaredRatio(hs, 16, true)
+    );
+  }
+
+  // Table-level costs, against the standard library's own string hash (and
+  // with the hash value cached compactly).
+  printf("\n%10s %34s %6s %12s %12s\n", "key size", "container", "octets", "insert ns", "find ns");
+  const size_t keyCount = 1000000;
+  for (size_t keySize : {8U, 24U, 100U}) {
+    vector<u8string> keys;
+    keys.reserve(keyCount);
+    for (size_t n = 0; n != keyCount; ++n) {
+      u8string s(keySize, u8'x');
+      for (size_t i = 0, v = n; i != keySize && v != 0; ++i, v /= 26) {
+        s[i] = static_cast<char8_t>(u8'a' + v % 26);
+      }
+      keys.push_back(std::move(s));
+    }
+
+    benchmarkSet<unordered_set<HashWrapper<u8string>>>(keys, "unordered_set<HashWrapper>");
+    benchmarkSet<unordered_set<CompactHashWrapper<u8string>>>(keys, "unordered_set<CompactHashWrapper>");
+    benchmarkSet<unordered_set<std::u8string>>(keys, "unordered_set<std::u8string>");
+    benchmarkSet<FlatHashSet<HashWrapper<u8string>>>(keys, "FlatHashSet<HashWrapper>");
+    benchmarkSet<FlatHashSet<CompactHashWrapper<u8string>>>(keys, "FlatHashSet<CompactHashWrapper>");
+  }
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
@@ -0,0 +1,390 @@
+#include "header.hpp"
+#include <unordered_set>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cstdio>
+
+using core::check;
+using core::HashWrapper;
+using core::hashed;
+using core::u8string;
+using core::FlatHashSet;
+using core::FlatHashMap;
+using core::ConcurrentHashMap;
+using std::move;
+using std::vector;
+using std::unordered_set;
+using std::unordered_map;
+using std::thread;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+size_t liveCount, hashCount;
+
+// Counts its live instances and how many times it is hashed.
+class CountedThing {
+  prv int v;
+
+  pub explicit CountedThing (int v) noexcept : v(v) {
+    ++liveCount;
+  }
+
+  pub CountedThing (const CountedThing &o) noexcept : v(o.v) {
+    ++liveCount;
+  }
+
+  pub CountedThing (CountedThing &&o) noexcept : v(o.v) {
+    ++liveCount;
+  }
+
+  pub ~CountedThing () noexcept {
+    --liveCount;
+  }
+
+  pub int get () const noexcept {
+    return v;
+  }
+
+  pub size_t hashSlow () const noexcept {
+    ++hashCount;
+    return core::hash(reinterpret_cast<const iu8f *>(&v), reinterpret_cast<const iu8f *>(&v + 1));
+  }
+
+  pub bool operator== (const CountedThing &r) const noexcept {
+    return v == r.v;
+  }
+};
+
+// Gives the same hash value for all of its instances.
+class CollidingThing {
+  prv int v;
+
+  pub explicit CollidingThing (int v) noexcept : v(v) {
+  }
+
+  pub size_t hashFast () const noexcept {
+    return 42;
+  }
+
+  pub bool operator== (const CollidingThing &r) const noexcept {
+    return v == r.v;
+  }
+};
+
+template<typename _G> void testSet () {
+  // Check against unordered_set over a long series of insertions and erasures
+  // (which grows the table and reuses deleted slots).
+  typedef HashWrapper<u8string> K;
+  FlatHashSet<K, _G> s;
+  unordered_set<K> expected;
+  check(s.empty());
+  check(s.begin() == s.end());
+  check(!s.contains(hashed(createKey(1))));
+  check(0U, s.erase(hashed(createKey(1))));
+  iu32f rnd = 1;
+  for (size_t n = 0; n != 20000; ++n) {
+    rnd = rnd * 1103515245 + 12345;
+    K k = hashed(createKey((rnd >> 16) % 3000));
+    if ((rnd >> 8) % 3 == 0) {
+      check(expected.erase(k), s.erase(k));
+    } else {
+      auto r = s.insert(k);
+      check(expected.insert(k).second, r.second);
+      check(k == *r.first);
+    }
+    check(expected.size(), s.size());
+  }
+  for (size_t n = 0; n != 3000; ++n) {
+    K k = hashed(createKey(n));
+    check(expected.count(k) != 0, s.contains(k));
+    check(expected.count(k) != 0, s.find(k) != s.end());
+  }
+  size_t count = 0;
+  for (const K &k : s) {
+    check(expected.count(k) != 0);
+    ++count;
+  }
+  check(expected.size(), count);
+
+  FlatHashSet<K, _G> copy(s);
+  check(s.size(), copy.size());
+  for (const K &k : s) {
+    check(copy.contains(k));
+  }
+  FlatHashSet<K, _G> moved(move(copy));
+  check(s.size(), moved.size());
+  check(copy.empty());
+  copy = moved;
+  check(s.size(), copy.size());
+
+  // Check erasure via iterators.
+  for (auto i = moved.begin(); i != moved.end();) {
+    i = moved.erase(i);
+  }
+  check(moved.empty());
+  check(moved.begin() == moved.end());
+  check(moved.insert(hashed(createKey(5))).second);
+  check(!moved.emplace(createKey(5)).second);
+  check(1U, moved.size());
+
+  copy.clear();
+  check(copy.empty());
+  check(copy.begin() == copy.end());
+  check(copy.insert(hashed(createKey(5))).second);
+  check(copy.contains(hashed(createKey(5))));
+
+  // Check that elements are hashed only on construction (rather than when the
+  // table grows) and that none are leaked.
+  liveCount = hashCount = 0;
+  {
+    FlatHashSet<HashWrapper<CountedThing>, _G> cs;
+    for (int v = 0; v != 1000; ++v) {
+      cs.emplace(v);
+    }
+    check(1000U, hashCount);
+    check(1000U, liveCount);
+    for (int v = 0; v != 1000; v += 2) {
+      check(1U, cs.erase(HashWrapper<CountedThing>(v)));
+    }
+    check(500U, liveCount);
+    cs.reserve(5000);
+    check(500U, liveCount);
+    check(1500U, hashCount);
+  }
+  check(0U, liveCount);
+
+  // Check that everything works even when all of the hash values collide.
+  FlatHashSet<CollidingThing, _G> colliding;
+  for (int v = 0; v != 100; ++v) {
+    check(colliding.emplace(v).second);
+  }
+  for (int v = 0; v < 100; v += 3) {
+    check(1U, colliding.erase(CollidingThing(v)));
+  }
+  for (int v = 0; v != 100; ++v) {
+    check(v % 3 != 0, colliding.contains(CollidingThing(v)));
+  }
+}
+
+template<typename _G> void testMap () {
+  typedef HashWrapper<u8string> K;
+  FlatHashMap<K, size_t, _G> m;
+  unordered_map<K, size_t> expected;
+  for (size_t n = 0; n != 5000; ++n) {
+    K k = hashed(createKey(n % 1700));
+    m[k] += n;
+    expected[k] += n;
+  }
+  check(expected.size(), m.size());
+  for (const auto &e : m) {
+    check(expected.at(e.getKey()), e.getValue());
+  }
+
+  auto r = m.try_emplace(hashed(createKey(3)), 7U);
+  check(!r.second);
+  check(expected.at(hashed(createKey(3))), r.first->getValue());
+  r = m.try_emplace(hashed(createKey(1700)), 7U);
+  check(r.second);
+  check(7U, r.first->getValue());
+  r.first->getValue() = 8;
+  check(8U, m.find(hashed(createKey(1700)))->getValue());
+  check(1U, m.erase(hashed(createKey(1700))));
+  check(m.find(hashed(createKey(1700))) == m.end());
+
+  const FlatHashMap<K, size_t, _G> &constM = m;
+  check(expected.at(hashed(createKey(4))), constM.find(hashed(createKey(4)))->getValue());
+
+  FlatHashMap<K, vector<int>, _G> vm;
+  vm[hashed(createKey(1))].push_back(1);
+  vm[hashed(createKey(1))].push_back(2);
+  check(2U, vm[hashed(createKey(1))].size());
+  check(vm[hashed(createKey(2))].empty());
+}
+
+}
+
+// Each test is run with each kind of Group that the target supports (so the
+// portable one is tested even where the tables don't use it by default).
+void testFlatHashSet () {
+  testSet<core::flathash::WordGroup>();
+  #if defined(ARCH_X86) && defined(__SSE2__)
+  testSet<core::flathash::Sse2Group>();
+  #endif
+}
+
+void testFlatHashMap () {
+  testMap<core::flathash::WordGroup>();
+  #if defined(ARCH_X86) && defined(__SSE2__)
+  testMap<core::flathash::Sse2Group>();
+  #endif
+}
+
+void testConcurrentHashMap () {
+  typedef HashWrapper<u8string> K;
+  ConcurrentHashMap<K, size_t> m(16);
+  check(0U, m.size());
+  check(!m.contains(hashed(createKey(1))));
+  check(!m.get(hashed(createKey(1))).has_value());
+  check(m.try_emplace(hashed(createKey(1)), 5U));
+  check(!m.try_emplace(hashed(createKey(1)), 6U));
+  check(5U, *m.get(hashed(createKey(1))));
+  check(!m.insert_or_assign(hashed(createKey(1)), 7U));
+  check(m.insert_or_assign(hashed(createKey(2)), 8U));
+  size_t seen = 0;
+  check(m.visit(hashed(createKey(1)), [&] (const size_t &v) {
+    seen = v;
+  }));
+  check(7U, seen);
+  check(!m.visit(hashed(createKey(3)), [&] (const size_t &) {
+    check(false);
+  }));
+  check(m.erase(hashed(createKey(2))));
+  check(!m.erase(hashed(createKey(2))));
+  check(1U, m.size());
+  m.clear();
+  check(0U, m.size());
+
+  // Have threads concurrently count into shared entries, insert and erase their
+  // own entries and read everything, and then check that nothing was lost.
+  const size_t threadCount = 8;
+  const size_t sharedKeyCount = 50;
+  const size_t opCount = 20000;
+  vector<K> sharedKeys;
+  for (size_t k = 0; k != sharedKeyCount; ++k) {
+    sharedKeys.push_back(hashed(createKey(k)));
+  }
+  vector<vector<size_t>> increments(threadCount, vector<size_t>(sharedKeyCount, 0));
+  vector<vector<bool>> owned(threadCount);
+  vector<thread> threads;
+  for (size_t t = 0; t != threadCount; ++t) {
+    threads.emplace_back([&, t] () {
+      vector<bool> &own = owned[t];
+      own.assign(500, false);
+      iu32f rnd = static_cast<iu32f>(t + 1);
+      for (size_t n = 0; n != opCount; ++n) {
+        rnd = rnd * 1103515245 + 12345;
+        size_t k = (rnd >> 16) % sharedKeyCount;
+        size_t ownK = (rnd >> 8) % own.size();
+        K ownKey = hashed(createKey(1000 + t * 1000 + ownK));
+        switch ((rnd >> 24) % 4) {
+          case 0:
+            m.update(sharedKeys[k], [] (size_t &v) {
+              ++v;
+            });
+            ++increments[t][k];
+            break;
+          case 1:
+            m.visit(sharedKeys[k], [] (const size_t &v) {
+              check(v != 0);
+            });
+            break;
+          case 2:
+            check(!own[ownK], m.try_emplace(ownKey, t));
+            own[ownK] = true;
+            break;
+          default:
+            check(own[ownK], m.erase(ownKey));
+            own[ownK] = false;
+            break;
+        }
+      }
+    });
+  }
+  for (thread &th : threads) {
+    th.join();
+  }
+
+  size_t expectedSize = 0;
+  for (size_t k = 0; k != sharedKeyCount; ++k) {
+    size_t total = 0;
+    for (size_t t = 0; t != threadCount; ++t) {
+      total += increments[t][k];
+    }
+    check(total, m.get(sharedKeys[k]).value_or(0));
+    expectedSize += (total != 0);
+  }
+  for (size_t t = 0; t != threadCount; ++t) {
+    for (size_t ownK = 0; ownK != owned[t].size(); ++ownK) {
+      check(owned[t][ownK], m.contains(hashed(createKey(1000 + t * 1000 + ownK))));
+      expectedSize += owned[t][ownK];
+    }
+  }
+  check(expectedSize, m.size());
+  size_t forEachCount = 0;
+  m.forEach([&] (const K &, const size_t &) {
+    ++forEachCount;
+  });
+  check(expectedSize, forEachCount);
+}
+
+void benchmarkConcurrentHashMap () {
+  // Compare ConcurrentHashMap with an unordered_map behind one mutex, over a
+  // workload of mostly reads, for increasing numbers of threads.
+  typedef HashWrapper<u8string> K;
+  const size_t keyCount = 100000;
+  const size_t opCount = 1000000;
+  vector<K> keys;
+  for (size_t k = 0; k != keyCount; ++k) {
+    keys.push_back(hashed(createKey(k * 7919)));
+  }
+
+  ConcurrentHashMap<K, size_t> cm(256);
+  unordered_map<K, size_t> um;
+  std::mutex umMutex;
+  for (size_t k = 0; k != keyCount; ++k) {
+    cm.try_emplace(keys[k], k);
+    um.emplace(keys[k], k);
+  }
+
+  size_t maxThreadCount = std::max(1U, thread::hardware_concurrency());
+  for (size_t threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2) {
+    for (iu variant = 0; variant != 2; ++variant) {
+      std::atomic<size_t> sum(0);
+      auto start = std::chrono::steady_clock::now();
+      vector<thread> threads;
+      for (size_t t = 0; t != threadCount; ++t) {
+        threads.emplace_back([&, t] () {
+          size_t localSum = 0;
+          iu32f rnd = static_cast<iu32f>(t + 1);
+          for (size_t n = 0; n != opCount / threadCount; ++n) {
+            rnd = rnd * 1103515245 + 12345;
+            const K &key = keys[(rnd >> 4) % keyCount];
+            bool write = (rnd >> 28) == 0;
+            if (variant == 0) {
+              if (write) {
+                cm.update(key, [] (size_t &v) {
+                  ++v;
+                });
+              } else {
+                cm.visit(key, [&] (const size_t &v) {
+                  localSum += v;
+                });
+              }
+            } else {
+              std::lock_guard<std::mutex> lock(umMutex);
+              if (write) {
+                ++um[key];
+              } else {
+                localSum += um.find(key)->second;
+              }
+            }
+          }
+          sum += localSum;
+        });
+      }
+      for (thread &th : threads) {
+        th.join();
+      }
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      printf("%s, %u threads: %.1f Mop/s\n", variant == 0 ? "ConcurrentHashMap" : "unordered_map + mutex", static_cast<unsigned>(threadCount), static_cast<double>(opCount) / ms / 1000.0);
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
@@ -12,6 +12,29 @@ int main (int argc, char *argv[]);
 extern const char *processName;
 std::tuple<int, std::vector<std::string>> rerun (const char *arg);
 
+/**
+  A small deterministic generator (splitmix64), so that tests and measurements
+  are repeatable.
+*/
+class Random {
+  prv iu64f state;
+
+  pub explicit Random (iu64f seed) noexcept;
+
+  pub iu64f next () noexcept;
+  /**
+    Returns a value of a random number of significant bits (rather than one
+    that almost always has the top bits set).
+  */
+  pub iu64f nextOfAnySize () noexcept;
+  pub void fill (iu8f *i, iu8f *end) noexcept;
+};
+
+/**
+  Returns a string that is distinct for each {@p n}.
+*/
+core::u8string createKey (size_t n);
+
 void testVersionSuccess ();
 void testVersionFailure0 ();
 void testVersionFailure0Impl ();
@@ -35,7 +58,37 @@ void testExtendSign ();
 void testShifting ();
 void testSetAndGet ();
 void testIex ();
+void testIexArrays ();
+void testIpx ();
+void benchmarkIex ();
+void testHash ();
+void testHasher ();
 void testHashing ();
+void testCompositeHashing ();
+void testCompactHashWrapper ();
+void testHashingString ();
+void testRollingHash ();
+void testChunker ();
+void benchmarkChunker ();
+void testKeyedHashing ();
+void testHashBatch ();
+void testConstantHashing ();
+void testHashedView ();
+void testHashAvalanche ();
+void testHashDistribution ();
+void benchmarkHash ();
+void testFlatHashSet ();
+void testFlatHashMap ();
+void testConcurrentHashMap ();
+void benchmarkConcurrentHashMap ();
+void testInterner ();
+void testConcurrentInterner ();
+void testBloomFilter ();
+void benchmarkBloomFilter ();
+void testDeltaSequence ();
+void benchmarkDeltaSequence ();
+void testOctetStreams ();
+void benchmarkOctetStreams ();
 void testUnicodeCodeUnits ();
 
 /* -----------------------------------------------------------------------------
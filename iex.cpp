@@ -0,0 +1,660 @@
+#include "header.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+using core::check;
+using core::writeIeu;
+using core::writeIes;
+using core::readIeu;
+using core::readIes;
+using core::readIeuArray;
+using core::readIesArray;
+using core::writeIeuArray;
+using core::writeIesArray;
+using core::getIeuArraySize;
+using core::getIesArraySize;
+using core::getIeuSize;
+using core::getIesSize;
+using core::writeIpu;
+using core::writeIps;
+using core::readIpu;
+using core::readIps;
+using core::readValidIpu;
+using core::readValidIps;
+using core::getIpuSize;
+using core::getIpsSize;
+using core::PlainException;
+using core::SkipKernel;
+using core::setSkipKernel;
+using core::getSkipKernel;
+using std::vector;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+// Creates values of mixed sizes, of no more than maxBits bits except for one in
+// about every largeOneIn (which are of the full width).
+template<typename _i> vector<_i> createValues (size_t count, iu maxBits, Random &r_random, iu largeOneIn = 50) {
+  vector<_i> values;
+  for (size_t n = 0; n != count; ++n) {
+    iu bits = static_cast<iu>(r_random.next() % (maxBits + 1));
+    if (r_random.next() % largeOneIn == 0) {
+      bits = sizeof(_i) * 8;
+    }
+    iu64f v = r_random.next();
+    v = bits >= 64 ? v : v & ((static_cast<iu64f>(1) << bits) - 1);
+    values.push_back(static_cast<_i>(v));
+  }
+  return values;
+}
+
+template<typename _i> vector<iu8f> encode (const vector<_i> &values) {
+  vector<iu8f> octets;
+  auto out = std::back_inserter(octets);
+  for (_i value : values) {
+    if constexpr (std::is_signed_v<_i>) {
+      writeIes(out, value);
+    } else {
+      writeIeu(out, value);
+    }
+  }
+  return octets;
+}
+
+enum class Outcome {
+  success, truncated, overflowed
+};
+
+// Decodes count values from octets, either with the array function or one at
+// a time, giving the values read before any exception and where reading got
+// to.
+template<typename _i> std::tuple<Outcome, vector<_i>, size_t> decode (const vector<iu8f> &octets, size_t count, bool inBulk) {
+  vector<_i> values(count, static_cast<_i>(0x5A));
+  const iu8f *ptr = octets.data();
+  const iu8f *ptrEnd = ptr + octets.size();
+  size_t n = 0;
+  Outcome outcome = Outcome::success;
+  try {
+    if (inBulk) {
+      if constexpr (std::is_signed_v<_i>) {
+        readIesArray(ptr, ptrEnd, values.data(), count);
+      } else {
+        readIeuArray(ptr, ptrEnd, values.data(), count);
+      }
+      n = count;
+    } else {
+      for (; n != count; ++n) {
+        if constexpr (std::is_signed_v<_i>) {
+          values[n] = readIes<_i>(ptr, ptrEnd);
+        } else {
+          values[n] = readIeu<_i>(ptr, ptrEnd);
+        }
+      }
+    }
+  } catch (const PlainException &) {
+    outcome = Outcome::truncated;
+  } catch (const std::overflow_error &) {
+    outcome = Outcome::overflowed;
+  }
+  if (inBulk && outcome != Outcome::success) {
+    n = 0;
+  }
+  return {outcome, vector<_i>(values.begin(), values.begin() + static_cast<ptrdiff_t>(n)), core::offset(octets.data(), ptr)};
+}
+
+// Checks that the array function agrees with the single-value one, including
+// on where it fails and on what (in which case the values that it wrote are
+// checked against those read singly).
+template<typename _i> void checkDecoding (const vector<iu8f> &octets, size_t count) {
+  auto [outcome, values, consumed] = decode<_i>(octets, count, false);
+  vector<_i> bulkValues(count, static_cast<_i>(0x5A));
+  const iu8f *ptr = octets.data();
+  Outcome bulkOutcome = Outcome::success;
+  try {
+    if constexpr (std::is_signed_v<_i>) {
+      readIesArray(ptr, octets.data() + octets.size(), bulkValues.data(), count);
+    } else {
+      readIeuArray(ptr, octets.data() + octets.size(), bulkValues.data(), count);
+    }
+  } catch (const PlainException &) {
+    bulkOutcome = Outcome::truncated;
+  } catch (const std::overflow_error &) {
+    bulkOutcome = Outcome::overflowed;
+  }
+  check(outcome == bulkOutcome);
+  check(consumed, core::offset(octets.data(), ptr));
+  check(values.begin(), values.end(), bulkValues.begin(), bulkValues.begin() + static_cast<ptrdiff_t>(values.size()));
+}
+
+template<typename _i> void testArray (iu maxBits, Random &r_random) {
+  for (size_t count : {0U, 1U, 15U, 16U, 17U, 100U, 3000U}) {
+    vector<_i> values = createValues<_i>(count, maxBits, r_random);
+    vector<iu8f> octets = encode(values);
+    auto [outcome, decodedValues, consumed] = decode<_i>(octets, count, true);
+    check(outcome == Outcome::success);
+    check(values.begin(), values.end(), decodedValues.begin(), decodedValues.end());
+    check(octets.size(), consumed);
+
+    // Check truncation (at every point, for short streams).
+    for (size_t size = octets.size(); size-- != 0;) {
+      if (octets.size() < 200 || r_random.next() % 64 == 0) {
+        checkDecoding<_i>(vector<iu8f>(octets.begin(), octets.begin() + static_cast<ptrdiff_t>(size)), count);
+      }
+    }
+  }
+}
+
+template<typename _i> void testInvalidArrays (Random &r_random) {
+  // Put a value that overflows _i (being too long or having too big a final
+  // octet) among short values.
+  for (iu extraSize : {0U, 1U, 3U}) {
+    for (size_t pos : {0U, 5U, 40U, 99U}) {
+      vector<_i> values = createValues<_i>(100, 7, r_random);
+      vector<iu8f> octets = encode(values);
+      size_t octetI = 0;
+      const iu8f *ptr = octets.data();
+      for (size_t n = 0; n != pos; ++n) {
+        if constexpr (std::is_signed_v<_i>) {
+          readIes<_i>(ptr, octets.data() + octets.size());
+        } else {
+          readIeu<_i>(ptr, octets.data() + octets.size());
+        }
+      }
+      octetI = core::offset(static_cast<const iu8f *>(octets.data()), ptr);
+      vector<iu8f> bad(static_cast<size_t>(core::numeric_limits<_i>::max_ie_octets) - 1 + extraSize, 0xFF);
+      bad.push_back(extraSize == 0 ? 0x7F : 0x00);
+      octets.insert(octets.begin() + static_cast<ptrdiff_t>(octetI), bad.begin(), bad.end());
+      checkDecoding<_i>(octets, 101);
+    }
+  }
+
+  // Check that overlong encodings of small values are accepted.
+  vector<iu8f> octets;
+  for (size_t n = 0; n != 40; ++n) {
+    octets.push_back(0x81);
+    octets.push_back(0x00);
+  }
+  checkDecoding<_i>(octets, 40);
+}
+
+// Checks that reading from a pointer (a word at a time where there's room)
+// agrees with reading from an iterator (an octet at a time), value by value
+// until the end or the first failure.
+template<typename _i> void checkWordReading (const vector<iu8f> &octets) {
+  const iu8f *ptr = octets.data();
+  const iu8f *ptrEnd = ptr + octets.size();
+  auto i = octets.cbegin();
+  while (i != octets.cend()) {
+    _i value = 0, iValue = 0;
+    Outcome outcome = Outcome::success, iOutcome = Outcome::success;
+    try {
+      if constexpr (std::is_signed_v<_i>) {
+        value = readIes<_i>(ptr, ptrEnd);
+      } else {
+        value = readIeu<_i>(ptr, ptrEnd);
+      }
+    } catch (const PlainException &) {
+      outcome = Outcome::truncated;
+    } catch (const std::overflow_error &) {
+      outcome = Outcome::overflowed;
+    }
+    try {
+      if constexpr (std::is_signed_v<_i>) {
+        iValue = readIes<_i>(i, octets.cend());
+      } else {
+        iValue = readIeu<_i>(i, octets.cend());
+      }
+    } catch (const PlainException &) {
+      iOutcome = Outcome::truncated;
+    } catch (const std::overflow_error &) {
+      iOutcome = Outcome::overflowed;
+    }
+    check(iOutcome == outcome);
+    check(iValue, value);
+    check(core::offset(octets.cbegin(), i), core::offset(static_cast<const iu8f *>(octets.data()), ptr));
+    if (outcome != Outcome::success) {
+      break;
+    }
+  }
+}
+
+template<typename _i> void testWordReading (Random &r_random) {
+  for (iu maxBits : {7U, 21U, 64U}) {
+    checkWordReading<_i>(encode(createValues<_i>(200, maxBits, r_random)));
+  }
+
+  // Check random octets (which are mostly continuation octets, to give long
+  // values, some of which overflow).
+  for (size_t n = 0; n != 2000; ++n) {
+    vector<iu8f> octets(r_random.next() % 24);
+    iu64f continuationChance = r_random.next() % 8;
+    for (iu8f &r_octet : octets) {
+      r_octet = static_cast<iu8f>(r_random.next());
+      r_octet = static_cast<iu8f>(r_random.next() % 8 < continuationChance ? r_octet | 0x80 : r_octet & 0x7F);
+    }
+    checkWordReading<_i>(octets);
+  }
+}
+
+template<typename _i> vector<iu8f> encodeIpx (const vector<_i> &values) {
+  vector<iu8f> octets;
+  auto out = std::back_inserter(octets);
+  for (_i value : values) {
+    if constexpr (std::is_signed_v<_i>) {
+      writeIps(out, value);
+    } else {
+      writeIpu(out, value);
+    }
+  }
+  return octets;
+}
+
+template<typename _i, typename _InputIterator, typename _InputEndIterator> _i readIpx (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd) {
+  if constexpr (std::is_signed_v<_i>) {
+    return readIps<_i>(r_ptr, ptrEnd);
+  } else {
+    return readIpu<_i>(r_ptr, ptrEnd);
+  }
+}
+
+template<typename _i> void testIpxValues (iu maxBits, Random &r_random) {
+  vector<_i> values = createValues<_i>(300, maxBits, r_random);
+  values[0] = core::numeric_limits<_i>::max();
+  values[1] = core::numeric_limits<_i>::min();
+  values[2] = 0;
+  values[3] = static_cast<_i>(-1);
+  vector<iu8f> octets = encodeIpx(values);
+
+  // Check the sizes, and reading from a pointer (a word at a time, away from
+  // the end), from an iterator and without validation.
+  size_t size = 0;
+  for (_i value : values) {
+    if constexpr (std::is_signed_v<_i>) {
+      size += getIpsSize(value);
+    } else {
+      size += getIpuSize(value);
+    }
+  }
+  check(octets.size(), size);
+  const iu8f *ptr = octets.data();
+  auto i = octets.cbegin();
+  const iu8f *validPtr = octets.data();
+  for (_i value : values) {
+    check(value, readIpx<_i>(ptr, octets.data() + octets.size()));
+    check(value, readIpx<_i>(i, octets.cend()));
+    if constexpr (std::is_signed_v<_i>) {
+      check(value, readValidIps<_i>(validPtr));
+    } else {
+      check(value, readValidIpu<_i>(validPtr));
+    }
+    check(core::offset(static_cast<const iu8f *>(octets.data()), ptr), core::offset(octets.cbegin(), i));
+    check(validPtr == ptr);
+  }
+  check(octets.data() + octets.size() == ptr);
+
+  // Check truncation, which must be noticed wherever it comes.
+  for (size_t truncatedSize = 0; truncatedSize != 60; ++truncatedSize) {
+    const iu8f *truncatedPtr = octets.data();
+    const iu8f *truncatedPtrEnd = octets.data() + truncatedSize;
+    try {
+      for (size_t n = 0; n != values.size(); ++n) {
+        readIpx<_i>(truncatedPtr, truncatedPtrEnd);
+      }
+      check(false);
+    } catch (const PlainException &) {
+      check(truncatedPtr == truncatedPtrEnd);
+    }
+  }
+}
+
+template<typename _i> void testIpxOverflow () {
+  // Check values just out of the range of _i (when _i is narrower than the
+  // widest type).
+  typedef typename std::conditional<std::is_signed_v<_i>, is64f, iu64f>::type W;
+  vector<W> values;
+  values.push_back(static_cast<W>(core::numeric_limits<_i>::max()) + 1);
+  if constexpr (std::is_signed_v<_i>) {
+    values.push_back(static_cast<W>(core::numeric_limits<_i>::min()) - 1);
+  }
+  for (W value : values) {
+    vector<iu8f> octets = encodeIpx(vector<W>{value});
+    octets.resize(octets.size() + 8);
+    const iu8f *ptr = octets.data();
+    auto i = octets.cbegin();
+    bool overflowed = false;
+    try {
+      readIpx<_i>(ptr, octets.data() + octets.size());
+    } catch (const std::overflow_error &) {
+      overflowed = true;
+    }
+    check(overflowed);
+    overflowed = false;
+    try {
+      readIpx<_i>(i, octets.cend());
+    } catch (const std::overflow_error &) {
+      overflowed = true;
+    }
+    check(overflowed);
+  }
+}
+
+// Checks that converting between the formats gives what writing the values
+// in the other format does.
+template<typename _i> void testIpxConversion (Random &r_random) {
+  vector<_i> values = createValues<_i>(1000, 64, r_random);
+  vector<iu8f> ieOctets = encode(values);
+  vector<iu8f> ipOctets = encodeIpx(values);
+  vector<iu8f> octets;
+  auto out = std::back_inserter(octets);
+  const iu8f *ptr = ieOctets.data();
+  if constexpr (std::is_signed_v<_i>) {
+    core::convertIesToIps(ptr, ieOctets.data() + ieOctets.size(), out, values.size());
+  } else {
+    core::convertIeuToIpu(ptr, ieOctets.data() + ieOctets.size(), out, values.size());
+  }
+  check(ieOctets.data() + ieOctets.size() == ptr);
+  check(ipOctets.begin(), ipOctets.end(), octets.begin(), octets.end());
+
+  octets.clear();
+  ptr = ipOctets.data();
+  if constexpr (std::is_signed_v<_i>) {
+    core::convertIpsToIes(ptr, ipOctets.data() + ipOctets.size(), out, values.size());
+  } else {
+    core::convertIpuToIeu(ptr, ipOctets.data() + ipOctets.size(), out, values.size());
+  }
+  check(ipOctets.data() + ipOctets.size() == ptr);
+  check(ieOctets.begin(), ieOctets.end(), octets.begin(), octets.end());
+}
+
+// Checks skipping and counting against reading, at every value boundary (or
+// a sample of them) and from unaligned starts.
+void testSkipping (iu maxBits, Random &r_random) {
+  // Each kernel that the executing CPU supports is tried in turn.
+  SkipKernel originalKernel = getSkipKernel();
+  for (iu k = 0; k != 3; ++k) {
+    if (!setSkipKernel(static_cast<SkipKernel>(k))) {
+      continue;
+    }
+    for (size_t count : {0U, 1U, 5U, 40U, 1000U}) {
+      vector<iu64f> values = createValues<iu64f>(count, maxBits, r_random);
+      vector<iu8f> octets = encode(values);
+      vector<const iu8f *> ends{octets.data()};
+      const iu8f *ptr = octets.data();
+      const iu8f *ptrEnd = octets.data() + octets.size();
+      for (size_t n = 0; n != count; ++n) {
+        readIeu<iu64f>(ptr, ptrEnd);
+        ends.push_back(ptr);
+      }
+
+      check(count, core::countIeu(octets.data(), ptrEnd));
+      for (size_t start = 0; start < count; start += 1 + r_random.next() % 16) {
+        for (size_t skipCount = 0; start + skipCount <= count; skipCount += 1 + r_random.next() % 32) {
+          ptr = ends[start];
+          core::skipIeu(ptr, ptrEnd, skipCount);
+          check(ends[start + skipCount] == ptr);
+          check(skipCount, core::countIeu(ends[start], ends[start + skipCount]));
+        }
+      }
+
+      // Check that a partial value at the end isn't counted, and can't be
+      // skipped.
+      octets.push_back(0x80);
+      ptrEnd = octets.data() + octets.size();
+      check(count, core::countIeu(octets.data(), ptrEnd));
+      ptr = octets.data();
+      bool truncated = false;
+      try {
+        core::skipIeu(ptr, ptrEnd, count + 1);
+      } catch (const PlainException &) {
+        truncated = true;
+      }
+      check(truncated);
+      check(ptrEnd == ptr);
+    }
+  }
+  check(setSkipKernel(originalKernel));
+}
+
+template<typename _i> void testArrayWriting (iu maxBits, Random &r_random) {
+  for (size_t count : {0U, 1U, 7U, 100U, 3000U}) {
+    vector<_i> values = createValues<_i>(count, maxBits, r_random);
+    if (count > 4) {
+      values[0] = core::numeric_limits<_i>::max();
+      values[1] = core::numeric_limits<_i>::min();
+      values[2] = 0;
+      values[3] = static_cast<_i>(-1);
+    }
+    vector<iu8f> expected = encode(values);
+
+    for (_i value : values) {
+      iu8f buffer[16];
+      iu8f *ptr = buffer;
+      if constexpr (std::is_signed_v<_i>) {
+        writeIes(ptr, value);
+        check(core::offset(buffer, ptr), getIesSize(value));
+      } else {
+        writeIeu(ptr, value);
+        check(core::offset(buffer, ptr), getIeuSize(value));
+      }
+    }
+
+    // Check the container form (appending to existing contents).
+    vector<iu8f> octets{0xAB};
+    if constexpr (std::is_signed_v<_i>) {
+      check(expected.size(), getIesArraySize(values.data(), count));
+      writeIesArray(octets, values.data(), count);
+    } else {
+      check(expected.size(), getIeuArraySize(values.data(), count));
+      writeIeuArray(octets, values.data(), count);
+    }
+    check(expected.size() + 1, octets.size());
+    check(0xAB, octets[0]);
+    check(expected.begin(), expected.end(), octets.begin() + 1, octets.end());
+    core::string<iu8f> octetString;
+    if constexpr (std::is_signed_v<_i>) {
+      writeIesArray(octetString, values.data(), count);
+    } else {
+      writeIeuArray(octetString, values.data(), count);
+    }
+    check(expected.begin(), expected.end(), octetString.begin(), octetString.end());
+
+    // Check the buffer form, with an exact and a roomy buffer (which mustn't be
+    // written past the values).
+    for (size_t spareSize : {0U, 20U}) {
+      vector<iu8f> buffer(expected.size() + spareSize, 0xCD);
+      iu8f *ptr = buffer.data();
+      if constexpr (std::is_signed_v<_i>) {
+        writeIesArray(ptr, buffer.data() + buffer.size(), values.data(), count);
+      } else {
+        writeIeuArray(ptr, buffer.data() + buffer.size(), values.data(), count);
+      }
+      check(buffer.data() + expected.size() == ptr);
+      check(expected.begin(), expected.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(expected.size()));
+    }
+  }
+}
+
+// Times reading values that are mostly short, but with rare large ones (which
+// mustn't leave the rest of an array to be read singly).
+template<typename _i> void benchmarkRareLargeIex (Random &r_random) {
+  typedef std::chrono::steady_clock Clock;
+  const size_t count = 1 << 22;
+  vector<_i> values = createValues<_i>(count, 14, r_random, 1000);
+  vector<iu8f> octets = encode(values);
+  vector<_i> decoded(count);
+  double nss[2];
+  for (size_t i = 0; i != 2; ++i) {
+    auto start = Clock::now();
+    const iu8f *ptr = octets.data();
+    const iu8f *ptrEnd = ptr + octets.size();
+    if (i == 0) {
+      for (size_t n = 0; n != count; ++n) {
+        if constexpr (std::is_signed_v<_i>) {
+          decoded[n] = readIes<_i>(ptr, ptrEnd);
+        } else {
+          decoded[n] = readIeu<_i>(ptr, ptrEnd);
+        }
+      }
+    } else {
+      if constexpr (std::is_signed_v<_i>) {
+        readIesArray(ptr, ptrEnd, decoded.data(), count);
+      } else {
+        readIeuArray(ptr, ptrEnd, decoded.data(), count);
+      }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    nss[i] = static_cast<double>(ns) / static_cast<double>(count);
+    check(values.begin(), values.end(), decoded.begin(), decoded.end());
+  }
+  printf(
+    "%s (up to 14 bits, 1 in 1000 of %zu bits): read singly %.2f ns, read as an array %.2f ns per value\n",
+    std::is_signed_v<_i> ? "ies" : "ieu", sizeof(_i) * 8, nss[0], nss[1]
+  );
+}
+
+}
+
+static_assert(getIeuSize(0U) == 1 && getIeuSize(127U) == 1 && getIeuSize(128U) == 2);
+static_assert(getIeuSize(core::numeric_limits<iu64f>::max()) == core::numeric_limits<iu64f>::max_ie_octets);
+static_assert(getIesSize(0) == 1 && getIesSize(63) == 1 && getIesSize(64) == 2 && getIesSize(-64) == 2);
+static_assert(getIesSize(core::numeric_limits<is64f>::min()) == core::numeric_limits<is64f>::max_ie_octets);
+
+void testIexArrays () {
+  Random random(1);
+  for (iu maxBits : {7U, 14U, 21U, 28U, 32U}) {
+    testArray<iu32f>(maxBits, random);
+    testArray<is32f>(maxBits, random);
+  }
+  for (iu maxBits : {7U, 14U, 35U, 49U, 64U}) {
+    testArray<iu64f>(maxBits, random);
+    testArray<is64f>(maxBits, random);
+  }
+  testArray<iu16f>(14, random);
+  testArray<unsigned char>(8, random);
+  for (iu maxBits : {7U, 14U, 28U, 32U}) {
+    testArrayWriting<iu32f>(maxBits, random);
+    testArrayWriting<is32f>(maxBits, random);
+  }
+  for (iu maxBits : {7U, 35U, 56U, 64U}) {
+    testArrayWriting<iu64f>(maxBits, random);
+    testArrayWriting<is64f>(maxBits, random);
+  }
+  testArrayWriting<iu16f>(16, random);
+  testArrayWriting<signed char>(8, random);
+  testWordReading<iu32f>(random);
+  testWordReading<iu64f>(random);
+  testWordReading<is32f>(random);
+  testWordReading<is64f>(random);
+  testWordReading<iu16f>(random);
+  testWordReading<unsigned char>(random);
+  testWordReading<signed char>(random);
+  for (iu maxBits : {7U, 14U, 35U, 64U}) {
+    testSkipping(maxBits, random);
+  }
+  testInvalidArrays<iu32f>(random);
+  testInvalidArrays<iu64f>(random);
+  testInvalidArrays<is32f>(random);
+  testInvalidArrays<is64f>(random);
+}
+
+static_assert(getIpuSize(0U) == 1 && getIpuSize(127U) == 1 && getIpuSize(128U) == 2);
+static_assert(getIpuSize((static_cast<iu64f>(1) << 56) - 1) == 8 && getIpuSize(static_cast<iu64f>(1) << 56) == 9);
+static_assert(getIpsSize(-64) == 1 && getIpsSize(64) == 2 && getIpsSize(core::numeric_limits<is64f>::min()) == 9);
+
+void testIpx () {
+  Random random(3);
+  for (iu maxBits : {7U, 14U, 32U}) {
+    testIpxValues<iu32f>(maxBits, random);
+    testIpxValues<is32f>(maxBits, random);
+  }
+  for (iu maxBits : {7U, 35U, 56U, 64U}) {
+    testIpxValues<iu64f>(maxBits, random);
+    testIpxValues<is64f>(maxBits, random);
+  }
+  testIpxValues<iu16f>(16, random);
+  testIpxValues<signed char>(8, random);
+  testIpxOverflow<iu32f>();
+  testIpxOverflow<is32f>();
+  testIpxOverflow<unsigned char>();
+  testIpxOverflow<signed char>();
+  testIpxConversion<iu64f>(random);
+  testIpxConversion<is64f>(random);
+}
+
+void benchmarkIex () {
+  typedef std::chrono::steady_clock Clock;
+  Random random(2);
+  const size_t count = 1 << 22;
+  for (iu maxBits : {7U, 14U, 21U, 32U}) {
+    vector<iu32f> values = createValues<iu32f>(count, maxBits, random);
+    vector<iu8f> octets = encode(values);
+    vector<iu32f> decoded(count);
+    double nss[2];
+    for (size_t i = 0; i != 2; ++i) {
+      auto start = Clock::now();
+      const iu8f *ptr = octets.data();
+      const iu8f *ptrEnd = ptr + octets.size();
+      if (i == 0) {
+        for (size_t n = 0; n != count; ++n) {
+          decoded[n] = readIeu<iu32f>(ptr, ptrEnd);
+        }
+      } else {
+        readIeuArray(ptr, ptrEnd, decoded.data(), count);
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+      nss[i] = static_cast<double>(ns) / static_cast<double>(count);
+      check(values.begin(), values.end(), decoded.begin(), decoded.end());
+    }
+    printf(
+      "ieu (up to %2u bits, %.2f octets per value): readIeu %.2f ns, readIeuArray %.2f ns per value\n",
+      maxBits, static_cast<double>(octets.size()) / static_cast<double>(count), nss[0], nss[1]
+    );
+
+    for (size_t i = 0; i != 2; ++i) {
+      auto start = Clock::now();
+      vector<iu8f> written;
+      if (i == 0) {
+        written = encode(values);
+      } else {
+        writeIeuArray(written, values.data(), count);
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+      nss[i] = static_cast<double>(ns) / static_cast<double>(count);
+      check(octets.begin(), octets.end(), written.begin(), written.end());
+    }
+    printf(
+      "ieu (up to %2u bits): writeIeu %.2f ns, writeIeuArray %.2f ns per value\n",
+      maxBits, nss[0], nss[1]
+    );
+
+    auto skipStart = Clock::now();
+    const iu8f *skipPtr = octets.data();
+    core::skipIeu(skipPtr, octets.data() + octets.size(), count);
+    auto skipNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - skipStart).count();
+    check(octets.data() + octets.size() == skipPtr);
+    printf("ieu (up to %2u bits): skipIeu %.3f ns per value\n", maxBits, static_cast<double>(skipNs) / static_cast<double>(count));
+
+    vector<iu8f> ipOctets = encodeIpx(values);
+    auto start = Clock::now();
+    const iu8f *ptr = ipOctets.data();
+    const iu8f *ptrEnd = ptr + ipOctets.size();
+    for (size_t n = 0; n != count; ++n) {
+      decoded[n] = readIpu<iu32f>(ptr, ptrEnd);
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    check(values.begin(), values.end(), decoded.begin(), decoded.end());
+    printf(
+      "ipu (up to %2u bits, %.2f octets per value): readIpu %.2f ns per value\n",
+      maxBits, static_cast<double>(ipOctets.size()) / static_cast<double>(count), static_cast<double>(ns) / static_cast<double>(count)
+    );
+  }
+
+  benchmarkRareLargeIex<iu64f>(random);
+  benchmarkRareLargeIex<is64f>(random);
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
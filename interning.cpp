@@ -0,0 +1,111 @@
+#include "header.hpp"
+#include <thread>
+
+using core::check;
+using core::HashWrapper;
+using core::hashed;
+using core::u8string;
+using core::u32string;
+using core::Interned;
+using core::Interner;
+using core::ConcurrentInterner;
+using core::FlatHashSet;
+using std::vector;
+using std::thread;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+void testInterner () {
+  Interner<char8_t> interner;
+  check(0U, interner.size());
+  check(!interner.find(u8"abc", u8"abc" + 3).has_value());
+
+  u8string abc(u8"abc");
+  Interned<char8_t> i0 = interner.intern(abc);
+  Interned<char8_t> i1 = interner.intern(abc.data(), abc.data() + abc.size());
+  Interned<char8_t> i2 = interner.intern(hashed(u8string(u8"abc")));
+  check(i0 == i1);
+  check(i0 == i2);
+  check(i0 == *interner.find(abc.data(), abc.data() + abc.size()));
+  check(1U, interner.size());
+  check(abc.size(), i0.size());
+  check(abc.begin(), abc.end(), i0.begin(), i0.end());
+  check(0, i0.data()[3]);
+  check(hashed(u8string(abc)).hashFast(), i0.hashFast());
+
+  Interned<char8_t> empty = interner.intern(u8string());
+  check(0U, empty.size());
+  check(0, empty.data()[0]);
+  check(!(empty == i0));
+
+  // Check that handles stay valid as the interner grows (over many blocks, and
+  // with strings longer than a block).
+  vector<Interned<char8_t>> is;
+  for (size_t n = 0; n != 5000; ++n) {
+    is.push_back(interner.intern(createKey(n)));
+  }
+  u8string longName(static_cast<u8string::size_type>(10000), u8'x');
+  Interned<char8_t> longI = interner.intern(longName);
+  check(longName.size(), longI.size());
+  check(5003U, interner.size());
+  for (size_t n = 0; n != 5000; ++n) {
+    u8string name = createKey(n);
+    check(name.begin(), name.end(), is[n].begin(), is[n].end());
+    check(is[n] == interner.intern(name));
+    check(!(is[n] == is[(n + 1) % 5000]));
+  }
+  check(5003U, interner.size());
+  check(longI == interner.intern(longName));
+  check(abc.begin(), abc.end(), i0.begin(), i0.end());
+
+  // Check that handles work as keys.
+  FlatHashSet<Interned<char8_t>> set;
+  for (size_t n = 0; n != 100; ++n) {
+    set.insert(is[n % 50]);
+  }
+  check(50U, set.size());
+  check(set.contains(interner.intern(createKey(7))));
+
+  Interner<char32_t> interner32;
+  u32string s32(U"wide");
+  Interned<char32_t> i32 = interner32.intern(s32);
+  check(s32.begin(), s32.end(), i32.begin(), i32.end());
+  check(hashed(u32string(s32)).hashFast(), i32.hashFast());
+  check(i32 == interner32.intern(hashed(u32string(s32))));
+}
+
+void testConcurrentInterner () {
+  // Have threads intern overlapping ranges of strings at once, and then check
+  // that each string got exactly one handle.
+  ConcurrentInterner<char8_t> interner(8);
+  const size_t threadCount = 8;
+  const size_t nameCount = 2000;
+  vector<vector<Interned<char8_t>>> iss(threadCount);
+  vector<thread> threads;
+  for (size_t t = 0; t != threadCount; ++t) {
+    threads.emplace_back([&, t] () {
+      for (size_t n = 0; n != nameCount; ++n) {
+        iss[t].push_back(interner.intern(createKey((n + t * 97) % nameCount)));
+      }
+    });
+  }
+  for (thread &th : threads) {
+    th.join();
+  }
+
+  check(nameCount, interner.size());
+  for (size_t t = 0; t != threadCount; ++t) {
+    for (size_t n = 0; n != nameCount; ++n) {
+      size_t nameN = (n + t * 97) % nameCount;
+      check(iss[0][nameN] == iss[t][n]);
+      u8string name = createKey(nameN);
+      check(name.begin(), name.end(), iss[t][n].begin(), iss[t][n].end());
+      check(iss[t][n] == *interner.find(name.data(), name.data() + name.size()));
+    }
+  }
+  check(iss[0][0] == interner.intern(hashed(createKey(0))));
+  check(!interner.find(u8"missing", u8"missing" + 7).has_value());
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
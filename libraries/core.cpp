@@ -1,4 +1,20 @@
 #include "core.hpp"
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cerrno>
+#ifdef ARCH_X86
+#include <immintrin.h>
+#endif
+#ifdef OS_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 LIB_DEPENDENCIES
 
@@ -156,14 +172,1306 @@ void check (const bool &cond) noexcept {
 
 /* -----------------------------------------------------------------------------
 ----------------------------------------------------------------------------- */
-size_t hash (const iu8f *i, const iu8f *end) noexcept {
-  size_t r = 0;
-  for (; i != end; ++i) {
-    r = 31 * r + *i;
+// The block decoders for the variable-length formats. Only values that are
+// known to be valid are decoded here: anything else (a value running past the
+// end of the input, or long enough that it might overflow) is left to
+// readIeu()/readIes(), so that invalid input is thrown on exactly as it is
+// there.
+
+namespace {
+
+// Decodes values one at a time, while they are short enough that they cannot
+// overflow.
+template<typename _i, bool _signed> size_t readIexBlockScalar (const iu8f *&r_ptr, const iu8f *ptrEnd, _i *out, size_t count) noexcept {
+  typedef typename std::make_unsigned<_i>::type U;
+  const size_t maxSize = (sizeof(_i) * 8 - 1) / 7;
+  const iu8f *ptr = r_ptr;
+  size_t n = 0;
+  for (; n != count; ++n) {
+    const iu8f *p = ptr;
+    U value = 0;
+    iu shift = 0;
+    iu8f octet;
+    for (;; ++p) {
+      if (p == ptrEnd || offset(ptr, p) == maxSize) {
+        r_ptr = ptr;
+        return n;
+      }
+      octet = *p;
+      if ((octet & 0x80) == 0) {
+        break;
+      }
+      value = static_cast<U>(value | static_cast<U>(static_cast<U>(octet & 0x7F) << shift));
+      shift += 7;
+    }
+
+    ++p;
+    if (_signed) {
+      value = static_cast<U>(value | static_cast<U>(static_cast<U>(octet & 0x3F) << shift));
+      out[n] = static_cast<_i>((octet & 0x40) != 0 ? static_cast<U>(0U - value) : value);
+    } else {
+      out[n] = static_cast<_i>(value | static_cast<U>(static_cast<U>(octet) << shift));
+    }
+    ptr = p;
+  }
+  r_ptr = ptr;
+  return n;
+}
+
+#ifdef ARCH_X86
+// The SIMD decoder follows the 'masked VByte' approach: the continuation bits
+// of the next 12 octets index a table of steps, each of which decodes the
+// values that start there together (six of 1-2 octets into 16-bit lanes, four
+// of 1-3 octets into 32-bit lanes or two of 1-5 octets into 64-bit lanes) by
+// shuffling their octets into lanes and then squeezing out the continuation
+// bits. Runs of one-octet values are decoded sixteen at a time.
+const iu iexShortShuffleCount = 64;
+const iu iexMediumShuffleCount = 81;
+const iu iexLongShuffleCount = 25;
+
+struct IexStep {
+  iu8f consumed;
+  iu8f shuffleI;
+};
+
+struct IexTables {
+  // (A step with 0 consumed has values that must be read singly.)
+  IexStep steps[4096];
+  alignas(16) iu8f shuffles[iexShortShuffleCount + iexMediumShuffleCount + iexLongShuffleCount][16];
+  // The sign bits of the signed format's values, in their lanes.
+  alignas(16) iu8f signMasks[iexShortShuffleCount + iexMediumShuffleCount + iexLongShuffleCount][16];
+};
+
+constexpr IexTables createIexTables () noexcept {
+  IexTables tables{};
+  for (iu mask = 0; mask != 4096; ++mask) {
+    iu sizes[12] = {};
+    iu valueCount = 0;
+    for (iu i = 0, start = 0; i != 12; ++i) {
+      if (((mask >> i) & 1) == 0) {
+        sizes[valueCount++] = i + 1 - start;
+        start = i + 1;
+      }
+    }
+    auto fits = [&] (iu n, iu maxSize) {
+      if (valueCount < n) {
+        return false;
+      }
+      for (iu j = 0; j != n; ++j) {
+        if (sizes[j] > maxSize) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    iu n, laneSize, shuffleI = 0;
+    if (fits(6, 2)) {
+      n = 6;
+      laneSize = 2;
+      for (iu j = 0; j != n; ++j) {
+        shuffleI += (sizes[j] - 1) << j;
+      }
+    } else if (fits(4, 3)) {
+      n = 4;
+      laneSize = 4;
+      for (iu j = 0, m = 1; j != n; ++j, m *= 3) {
+        shuffleI += (sizes[j] - 1) * m;
+      }
+      shuffleI += iexShortShuffleCount;
+    } else if (fits(2, 5)) {
+      n = 2;
+      laneSize = 8;
+      shuffleI = iexShortShuffleCount + iexMediumShuffleCount + (sizes[0] - 1) * 5 + (sizes[1] - 1);
+    } else {
+      continue;
+    }
+
+    iu8f *shuffle = tables.shuffles[shuffleI];
+    iu8f *signMask = tables.signMasks[shuffleI];
+    for (iu k = 0; k != 16; ++k) {
+      shuffle[k] = 0x80;
+      signMask[k] = 0;
+    }
+    iu consumed = 0;
+    for (iu j = 0; j != n; ++j) {
+      for (iu k = 0; k != sizes[j]; ++k) {
+        shuffle[j * laneSize + k] = static_cast<iu8f>(consumed + k);
+      }
+      iu signBitI = 7 * (sizes[j] - 1) + 6;
+      signMask[j * laneSize + signBitI / 8] = static_cast<iu8f>(1U << (signBitI % 8));
+      consumed += sizes[j];
+    }
+    tables.steps[mask] = IexStep{static_cast<iu8f>(consumed), static_cast<iu8f>(shuffleI)};
+  }
+  return tables;
+}
+
+constexpr IexTables iexTables = createIexTables();
+
+bool isIexSimdSupported () noexcept {
+  static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+  return supported;
+}
+
+// Returns the high halves for widening the lanes of v.
+template<bool _signed, iu _laneBits> __attribute__((target("ssse3"))) __m128i getLaneExtension (__m128i v) noexcept {
+  if constexpr (!_signed) {
+    return _mm_setzero_si128();
+  } else if constexpr (_laneBits == 8) {
+    return _mm_cmpgt_epi8(_mm_setzero_si128(), v);
+  } else if constexpr (_laneBits == 16) {
+    return _mm_srai_epi16(v, 15);
+  } else {
+    return _mm_srai_epi32(v, 31);
+  }
+}
+
+// Widens the lanes of v to _i and stores them all (which is 128 / _laneBits
+// values).
+template<typename _i, bool _signed, iu _laneBits> __attribute__((target("ssse3"))) void storeLanes (_i *out, __m128i v) noexcept {
+  if constexpr (_laneBits == sizeof(_i) * 8) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+  } else {
+    __m128i e = getLaneExtension<_signed, _laneBits>(v);
+    if constexpr (_laneBits == 8) {
+      storeLanes<_i, _signed, 16>(out, _mm_unpacklo_epi8(v, e));
+      storeLanes<_i, _signed, 16>(out + 8, _mm_unpackhi_epi8(v, e));
+    } else if constexpr (_laneBits == 16) {
+      storeLanes<_i, _signed, 32>(out, _mm_unpacklo_epi16(v, e));
+      storeLanes<_i, _signed, 32>(out + 4, _mm_unpackhi_epi16(v, e));
+    } else {
+      storeLanes<_i, _signed, 64>(out, _mm_unpacklo_epi32(v, e));
+      storeLanes<_i, _signed, 64>(out + 2, _mm_unpackhi_epi32(v, e));
+    }
+  }
+}
+
+// Turns sign-magnitude lanes (with sign bits where signMask has them) into
+// two's complement ones.
+template<iu _laneBits> __attribute__((target("ssse3"))) __m128i applySigns (__m128i v, __m128i signMask) noexcept {
+  __m128i signs = _mm_and_si128(v, signMask);
+  __m128i negatives = _laneBits == 16 ? _mm_cmpeq_epi16(signs, signMask) : _mm_cmpeq_epi32(signs, signMask);
+  __m128i mag = _mm_xor_si128(v, signs);
+  return _laneBits == 16 ? _mm_sub_epi16(_mm_xor_si128(mag, negatives), negatives) : _mm_sub_epi32(_mm_xor_si128(mag, negatives), negatives);
+}
+
+template<typename _i, bool _signed> __attribute__((target("ssse3"))) size_t readIexBlockSimd (const iu8f *&r_ptr, const iu8f *ptrEnd, _i *out, size_t count) noexcept {
+  const iu8f *ptr = r_ptr;
+  _i *o = out;
+  _i *oEnd = out + count;
+  // (Each iteration loads 16 octets and may store up to 16 values.)
+  while (offset(ptr, ptrEnd) >= 16 && offset(o, oEnd) >= 16) {
+    __m128i octets = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    auto mask = static_cast<iu>(_mm_movemask_epi8(octets));
+    if (mask == 0) {
+      __m128i v = octets;
+      if (_signed) {
+        __m128i signBits = _mm_set1_epi8(0x40);
+        __m128i negatives = _mm_cmpeq_epi8(_mm_and_si128(v, signBits), signBits);
+        v = _mm_sub_epi8(_mm_xor_si128(_mm_andnot_si128(signBits, v), negatives), negatives);
+      }
+      storeLanes<_i, _signed, 8>(o, v);
+      ptr += 16;
+      o += 16;
+      continue;
+    }
+
+    const IexStep &step = iexTables.steps[mask & 0xFFF];
+    if (step.consumed == 0) {
+      break;
+    }
+    __m128i x = _mm_shuffle_epi8(octets, _mm_load_si128(reinterpret_cast<const __m128i *>(iexTables.shuffles[step.shuffleI])));
+    __m128i signMask = _mm_load_si128(reinterpret_cast<const __m128i *>(iexTables.signMasks[step.shuffleI]));
+    if (step.shuffleI < iexShortShuffleCount) {
+      __m128i v = _mm_or_si128(
+        _mm_and_si128(x, _mm_set1_epi16(0x7F)), _mm_srli_epi16(_mm_and_si128(x, _mm_set1_epi16(0x7F00)), 1)
+      );
+      if (_signed) {
+        v = applySigns<16>(v, signMask);
+      }
+      storeLanes<_i, _signed, 16>(o, v);
+      o += 6;
+    } else if (step.shuffleI < iexShortShuffleCount + iexMediumShuffleCount) {
+      __m128i v = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(x, _mm_set1_epi32(0x7F)), _mm_srli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x7F00)), 1)),
+        _mm_srli_epi32(_mm_and_si128(x, _mm_set1_epi32(0x7F0000)), 2)
+      );
+      if (_signed) {
+        v = applySigns<32>(v, signMask);
+      }
+      storeLanes<_i, _signed, 32>(o, v);
+      o += 4;
+    } else {
+      // (Values of 5 octets of the signed format are left to be read singly.)
+      if (_signed) {
+        break;
+      }
+      __m128i v = _mm_and_si128(x, _mm_set1_epi64x(0x7F));
+      for (iu k = 1; k != 5; ++k) {
+        v = _mm_or_si128(v, _mm_srli_epi64(_mm_and_si128(x, _mm_set1_epi64x(static_cast<long long>(0x7FULL << (8 * k)))), static_cast<int>(k)));
+      }
+      if (sizeof(_i) == 4) {
+        if ((_mm_movemask_epi8(_mm_cmpeq_epi32(v, _mm_setzero_si128())) & 0xF0F0) != 0xF0F0) {
+          break;
+        }
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(o), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0)));
+      } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(o), v);
+      }
+      o += 2;
+    }
+    ptr += step.consumed;
+  }
+  r_ptr = ptr;
+  return offset(out, o);
+}
+#endif
+
+// A value that the SIMD decoder can't take stops it only for that value: the
+// value is decoded singly and then the SIMD decoder is tried again (until the
+// value is one that can't be decoded here at all, or the end is near).
+template<typename _i, bool _signed> size_t readIexBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, _i *out, size_t count) noexcept {
+  size_t n = 0;
+  #ifdef ARCH_X86
+  if (isIexSimdSupported()) {
+    while (true) {
+      n += readIexBlockSimd<_i, _signed>(r_ptr, ptrEnd, out + n, count - n);
+      if (offset(r_ptr, ptrEnd) < 16 || count - n < 16) {
+        break;
+      }
+      size_t singleN = readIexBlockScalar<_i, _signed>(r_ptr, ptrEnd, out + n, 1);
+      if (singleN == 0) {
+        return n;
+      }
+      n += singleN;
+    }
+  }
+  #endif
+  return n + readIexBlockScalar<_i, _signed>(r_ptr, ptrEnd, out + n, count - n);
+}
+
+}
+
+size_t readIeuBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, iu32f *out, size_t count) noexcept {
+  return readIexBlock<iu32f, false>(r_ptr, ptrEnd, out, count);
+}
+
+size_t readIeuBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, iu64f *out, size_t count) noexcept {
+  return readIexBlock<iu64f, false>(r_ptr, ptrEnd, out, count);
+}
+
+size_t readIesBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, is32f *out, size_t count) noexcept {
+  return readIexBlock<is32f, true>(r_ptr, ptrEnd, out, count);
+}
+
+size_t readIesBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, is64f *out, size_t count) noexcept {
+  return readIexBlock<is64f, true>(r_ptr, ptrEnd, out, count);
+}
+
+namespace {
+
+// Returns the index of the nth (from 1) lowest set bit of mask.
+iu getNthSetBitI (iu64f mask, size_t n) noexcept {
+  for (; n != 1; --n) {
+    mask &= mask - 1;
+  }
+  return static_cast<iu>(__builtin_ctzll(mask));
+}
+
+// The skipping kernels pass over octets until r_count terminators (octets
+// without the continuation bit) have been passed or the end is reached,
+// returning where they got to and reducing r_count by the number passed. They
+// find the terminators of a chunk at a time as a mask, and only look for the
+// last one they need within the mask.
+const iu8f *skipIexTerminatorOctets (const iu8f *ptr, const iu8f *end, size_t &r_count) noexcept {
+  for (; ptr != end && r_count != 0; ++ptr) {
+    r_count -= static_cast<size_t>((*ptr >> 7) ^ 1);
+  }
+  return ptr;
+}
+
+const iu8f *skipIexTerminatorsScalar (const iu8f *ptr, const iu8f *end, size_t &r_count) noexcept {
+  for (; r_count != 0 && offset(ptr, end) >= sizeof(iu64f); ptr += sizeof(iu64f)) {
+    iu64f word = get<iu64f>(ptr);
+    #ifdef ARCH_ENDIAN_BIG
+    word = __builtin_bswap64(word);
+    #endif
+    iu64f mask = ~word & 0x8080808080808080ULL;
+    auto c = static_cast<size_t>(__builtin_popcountll(mask));
+    if (c >= r_count) {
+      ptr += getNthSetBitI(mask, r_count) / 8 + 1;
+      r_count = 0;
+      return ptr;
+    }
+    r_count -= c;
+  }
+  return skipIexTerminatorOctets(ptr, end, r_count);
+}
+
+#ifdef ARCH_X86
+__attribute__((target("sse2,popcnt"))) const iu8f *skipIexTerminatorsSse2 (const iu8f *ptr, const iu8f *end, size_t &r_count) noexcept {
+  for (; r_count != 0 && offset(ptr, end) >= 16; ptr += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+    auto mask = static_cast<iu32f>(~_mm_movemask_epi8(v)) & 0xFFFF;
+    auto c = static_cast<size_t>(__builtin_popcount(mask));
+    if (c >= r_count) {
+      ptr += getNthSetBitI(mask, r_count) + 1;
+      r_count = 0;
+      return ptr;
+    }
+    r_count -= c;
+  }
+  return skipIexTerminatorOctets(ptr, end, r_count);
+}
+
+__attribute__((target("avx2,popcnt"))) const iu8f *skipIexTerminatorsAvx2 (const iu8f *ptr, const iu8f *end, size_t &r_count) noexcept {
+  for (; r_count != 0 && offset(ptr, end) >= 32; ptr += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+    auto mask = ~static_cast<iu32f>(_mm256_movemask_epi8(v));
+    auto c = static_cast<size_t>(__builtin_popcount(mask));
+    if (c >= r_count) {
+      ptr += getNthSetBitI(mask, r_count) + 1;
+      r_count = 0;
+      return ptr;
+    }
+    r_count -= c;
+  }
+  return skipIexTerminatorOctets(ptr, end, r_count);
+}
+#endif
+
+typedef const iu8f *(*SkipIexTerminatorsFn)(const iu8f *ptr, const iu8f *end, size_t &r_count);
+
+SkipIexTerminatorsFn getSkipIexTerminatorsFn (SkipKernel kernel) noexcept {
+  switch (kernel) {
+    #ifdef ARCH_X86
+    case SkipKernel::sse2:
+      return skipIexTerminatorsSse2;
+    case SkipKernel::avx2:
+      return skipIexTerminatorsAvx2;
+    #endif
+    default:
+      return skipIexTerminatorsScalar;
+  }
+}
+
+const char *const skipKernelNames[] = {"scalar", "sse2", "avx2"};
+
+const iu8f *skipIexTerminatorsUnbound (const iu8f *ptr, const iu8f *end, size_t &r_count) noexcept;
+
+std::atomic<SkipIexTerminatorsFn> boundSkipIexTerminators(skipIexTerminatorsUnbound);
+std::atomic<SkipKernel> boundSkipKernel(SkipKernel::scalar);
+
+// Picks the kernel named by the CORE_SKIP_KERNEL environment variable, if that
+// is supported, or else the best supported kernel.
+SkipKernel bindSkipKernel () noexcept {
+  SkipKernel kernel = SkipKernel::scalar;
+  for (iu i = sizeof(skipKernelNames) / sizeof(*skipKernelNames); i-- != 0;) {
+    if (isSkipKernelSupported(static_cast<SkipKernel>(i))) {
+      kernel = static_cast<SkipKernel>(i);
+      break;
+    }
+  }
+
+  const char *name = getenv("CORE_SKIP_KERNEL");
+  if (name) {
+    for (iu i = 0; i != sizeof(skipKernelNames) / sizeof(*skipKernelNames); ++i) {
+      if (strcmp(name, skipKernelNames[i]) == 0 && isSkipKernelSupported(static_cast<SkipKernel>(i))) {
+        kernel = static_cast<SkipKernel>(i);
+        break;
+      }
+    }
+  }
+
+  setSkipKernel(kernel);
+  return kernel;
+}
+
+const iu8f *skipIexTerminatorsUnbound (const iu8f *ptr, const iu8f *end, size_t &r_count) noexcept {
+  bindSkipKernel();
+  return boundSkipIexTerminators.load(std::memory_order_relaxed)(ptr, end, r_count);
+}
+
+const iu8f *skipIexTerminators (const iu8f *ptr, const iu8f *end, size_t &r_count) noexcept {
+  return boundSkipIexTerminators.load(std::memory_order_relaxed)(ptr, end, r_count);
+}
+
+}
+
+void skipIeu (const iu8f *&r_ptr, const iu8f *ptrEnd, size_t count) {
+  r_ptr = skipIexTerminators(r_ptr, ptrEnd, count);
+  if (count != 0) {
+    throw PlainException(u8"variable-length integers were truncated");
+  }
+}
+
+size_t countIeu (const iu8f *ptr, const iu8f *ptrEnd) noexcept {
+  size_t count = std::numeric_limits<size_t>::max();
+  skipIexTerminators(ptr, ptrEnd, count);
+  return std::numeric_limits<size_t>::max() - count;
+}
+
+bool isSkipKernelSupported (SkipKernel kernel) noexcept {
+  switch (kernel) {
+    case SkipKernel::scalar:
+      return true;
+    #ifdef ARCH_X86
+    case SkipKernel::sse2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("sse2");
+    case SkipKernel::avx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("avx2");
+    #endif
+    default:
+      return false;
+  }
+}
+
+bool setSkipKernel (SkipKernel kernel) noexcept {
+  if (!isSkipKernelSupported(kernel)) {
+    return false;
+  }
+
+  boundSkipKernel.store(kernel, std::memory_order_relaxed);
+  boundSkipIexTerminators.store(getSkipIexTerminatorsFn(kernel), std::memory_order_relaxed);
+  return true;
+}
+
+SkipKernel getSkipKernel () noexcept {
+  if (boundSkipIexTerminators.load(std::memory_order_relaxed) == skipIexTerminatorsUnbound) {
+    return bindSkipKernel();
+  }
+  return boundSkipKernel.load(std::memory_order_relaxed);
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+// The primitives of the hash engine are in core.ipp (so that hashing can be
+// done at compile time); here are the kernels that can do the bulk of the work
+// on long inputs, and the machinery for choosing between them.
+
+namespace {
+
+using namespace hashing;
+
+typedef void (*HashStripesFn)(iu64f *acc, const iu8f *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret);
+
+#ifdef ARCH_X86
+__attribute__((target("sse2"))) void accumulateStripesSse2 (iu64f *acc, const iu8f *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept {
+  __m128i *accV = reinterpret_cast<__m128i *>(acc);
+  __m128i a0 = _mm_loadu_si128(accV);
+  __m128i a1 = _mm_loadu_si128(accV + 1);
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(hashPrime32));
+
+  for (; stripeI != stripeEnd; ++stripeI, ptr += hashStripeSize) {
+    const __m128i *dV = reinterpret_cast<const __m128i *>(ptr);
+    const __m128i *kV = reinterpret_cast<const __m128i *>(secret + (stripeI & 7));
+    __m128i d0 = _mm_loadu_si128(dV);
+    __m128i d1 = _mm_loadu_si128(dV + 1);
+    __m128i dk0 = _mm_xor_si128(d0, _mm_loadu_si128(kV));
+    __m128i dk1 = _mm_xor_si128(d1, _mm_loadu_si128(kV + 1));
+    a0 = _mm_add_epi64(a0, _mm_add_epi64(_mm_mul_epu32(dk0, _mm_shuffle_epi32(dk0, _MM_SHUFFLE(0, 3, 0, 1))), _mm_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+    a1 = _mm_add_epi64(a1, _mm_add_epi64(_mm_mul_epu32(dk1, _mm_shuffle_epi32(dk1, _MM_SHUFFLE(0, 3, 0, 1))), _mm_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+
+    if ((stripeI + 1) % hashBlockStripeCount == 0) {
+      const __m128i *sV = reinterpret_cast<const __m128i *>(secret + 8);
+      a0 = _mm_xor_si128(_mm_xor_si128(a0, _mm_srli_epi64(a0, 47)), _mm_loadu_si128(sV));
+      a1 = _mm_xor_si128(_mm_xor_si128(a1, _mm_srli_epi64(a1, 47)), _mm_loadu_si128(sV + 1));
+      a0 = _mm_add_epi64(_mm_mul_epu32(a0, prime), _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(a0, 32), prime), 32));
+      a1 = _mm_add_epi64(_mm_mul_epu32(a1, prime), _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(a1, 32), prime), 32));
+    }
+  }
+
+  _mm_storeu_si128(accV, a0);
+  _mm_storeu_si128(accV + 1, a1);
+}
+
+__attribute__((target("avx2"))) void accumulateStripesAvx2 (iu64f *acc, const iu8f *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept {
+  __m256i *accV = reinterpret_cast<__m256i *>(acc);
+  __m256i a = _mm256_loadu_si256(accV);
+  const __m256i prime = _mm256_set1_epi32(static_cast<int>(hashPrime32));
+
+  for (; stripeI != stripeEnd; ++stripeI, ptr += hashStripeSize) {
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+    __m256i dk = _mm256_xor_si256(d, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(secret + (stripeI & 7))));
+    a = _mm256_add_epi64(a, _mm256_add_epi64(_mm256_mul_epu32(dk, _mm256_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1))), _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2))));
+
+    if ((stripeI + 1) % hashBlockStripeCount == 0) {
+      a = _mm256_xor_si256(_mm256_xor_si256(a, _mm256_srli_epi64(a, 47)), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(secret + 8)));
+      a = _mm256_add_epi64(_mm256_mul_epu32(a, prime), _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime), 32));
+    }
+  }
+
+  _mm256_storeu_si256(accV, a);
+}
+#endif
+
+HashStripesFn getHashStripesFn (HashKernel kernel) noexcept {
+  switch (kernel) {
+    #ifdef ARCH_X86
+    case HashKernel::sse2:
+      return accumulateStripesSse2;
+    case HashKernel::avx2:
+      return accumulateStripesAvx2;
+    #endif
+    default:
+      return accumulateStripesScalar<iu8f>;
+  }
+}
+
+const char *const hashKernelNames[] = {"scalar", "sse2", "avx2"};
+
+void accumulateStripesUnbound (iu64f *acc, const iu8f *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept;
+
+std::atomic<HashStripesFn> boundAccumulateStripes(accumulateStripesUnbound);
+std::atomic<HashKernel> boundHashKernel(HashKernel::scalar);
+
+// Picks the kernel named by the CORE_HASH_KERNEL environment variable, if that
+// is supported, or else the best supported kernel.
+HashKernel bindHashKernel () noexcept {
+  HashKernel kernel = HashKernel::scalar;
+  for (iu i = sizeof(hashKernelNames) / sizeof(*hashKernelNames); i-- != 0;) {
+    if (isHashKernelSupported(static_cast<HashKernel>(i))) {
+      kernel = static_cast<HashKernel>(i);
+      break;
+    }
+  }
+
+  const char *name = getenv("CORE_HASH_KERNEL");
+  if (name) {
+    for (iu i = 0; i != sizeof(hashKernelNames) / sizeof(*hashKernelNames); ++i) {
+      if (strcmp(name, hashKernelNames[i]) == 0 && isHashKernelSupported(static_cast<HashKernel>(i))) {
+        kernel = static_cast<HashKernel>(i);
+        break;
+      }
+    }
+  }
+
+  setHashKernel(kernel);
+  return kernel;
+}
+
+void accumulateStripesUnbound (iu64f *acc, const iu8f *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept {
+  bindHashKernel();
+  boundAccumulateStripes.load(std::memory_order_relaxed)(acc, ptr, stripeI, stripeEnd, secret);
+}
+
+// Batches are hashed a chunk at a time. The inputs in a chunk are sorted by
+// which path through the engine they take (and, for mid-length inputs, by how
+// many 16 octet pieces they have), so that each path is then run over a run
+// of independent inputs with no unpredictable branching between them.
+const size_t hashBatchChunkSize = 64;
+const size_t hashBatchClassCount = 11;
+
+void hashBatchWithSecret (const iu8f *const *is, const iu8f *const *ends, size_t count, size_t *hs, const iu64f *secret) noexcept {
+  while (count != 0) {
+    size_t chunkCount = std::min(hashBatchChunkSize, count);
+    size_t sizes[hashBatchChunkSize];
+    iu8f classNs[hashBatchClassCount][hashBatchChunkSize];
+    size_t classCounts[hashBatchClassCount] = {};
+    for (size_t n = 0; n != chunkCount; ++n) {
+      size_t size = offset(is[n], ends[n]);
+      sizes[n] = size;
+      size_t c = static_cast<size_t>((size > 3) + (size > 8)) + (size > 16) * ((std::min(size, static_cast<size_t>(129)) - 1) / 16);
+      classNs[c][classCounts[c]++] = static_cast<iu8f>(n);
+    }
+
+    for (size_t k = 0; k != classCounts[0]; ++k) {
+      size_t n = classNs[0][k];
+      hs[n] = static_cast<size_t>(hash0To3(is[n], sizes[n], secret));
+    }
+    for (size_t k = 0; k != classCounts[1]; ++k) {
+      size_t n = classNs[1][k];
+      hs[n] = static_cast<size_t>(hash4To8(is[n], sizes[n], secret));
+    }
+    for (size_t k = 0; k != classCounts[2]; ++k) {
+      size_t n = classNs[2][k];
+      hs[n] = static_cast<size_t>(hash9To16(is[n], sizes[n], secret));
+    }
+    for (size_t c = 3; c != hashBatchClassCount - 1; ++c) {
+      for (size_t k = 0; k != classCounts[c]; ++k) {
+        size_t n = classNs[c][k];
+        hs[n] = static_cast<size_t>(hash17To128(is[n], sizes[n], secret));
+      }
+    }
+    for (size_t k = 0; k != classCounts[hashBatchClassCount - 1]; ++k) {
+      size_t n = classNs[hashBatchClassCount - 1][k];
+      hs[n] = static_cast<size_t>(hashLong(is[n], sizes[n], secret));
+    }
+
+    is += chunkCount;
+    ends += chunkCount;
+    hs += chunkCount;
+    count -= chunkCount;
+  }
+}
+
+// splitmix64, as a generator of the words of derived secrets.
+iu64f generateSecretWord (iu64f &r_state) noexcept {
+  iu64f z = (r_state += hashPrime0);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+iu64f createProcessHashSeed () noexcept {
+  const char *seedText = getenv("CORE_HASH_SEED");
+  if (seedText) {
+    // A seed that doesn't parse would otherwise be taken as 0, which is as
+    // guessable as a seed can be, so don't run with it.
+    char *seedTextEnd;
+    errno = 0;
+    iu64f seed = strtoull(seedText, &seedTextEnd, 0);
+    if (seedTextEnd == seedText || *seedTextEnd != 0 || errno == ERANGE) {
+      dieHard("CORE_HASH_SEED is not a number\n");
+    }
+    return seed;
+  }
+
+  try {
+    std::random_device device;
+    return (static_cast<iu64f>(device()) << 32) ^ device();
+  } catch (...) {
+    // Fall back to whatever variation the clock and address space layout give us.
+  }
+  iu64f state = static_cast<iu64f>(std::chrono::steady_clock::now().time_since_epoch().count()) ^ reinterpret_cast<uintptr_t>(&state);
+  return generateSecretWord(state);
+}
+
+}
+
+void hashing::accumulateStripes (iu64f *acc, const iu8f *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept {
+  boundAccumulateStripes.load(std::memory_order_relaxed)(acc, ptr, stripeI, stripeEnd, secret);
+}
+
+void hashing::literalMustEndWithItsOnlyNullCharacter () noexcept {
+}
+
+bool isHashKernelSupported (HashKernel kernel) noexcept {
+  switch (kernel) {
+    case HashKernel::scalar:
+      return true;
+    #ifdef ARCH_X86
+    case HashKernel::sse2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case HashKernel::avx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    #endif
+    default:
+      return false;
+  }
+}
+
+bool setHashKernel (HashKernel kernel) noexcept {
+  if (!isHashKernelSupported(kernel)) {
+    return false;
+  }
+
+  boundHashKernel.store(kernel, std::memory_order_relaxed);
+  boundAccumulateStripes.store(getHashStripesFn(kernel), std::memory_order_relaxed);
+  return true;
+}
+
+HashKernel getHashKernel () noexcept {
+  if (boundAccumulateStripes.load(std::memory_order_relaxed) == accumulateStripesUnbound) {
+    return bindHashKernel();
+  }
+  return boundHashKernel.load(std::memory_order_relaxed);
+}
+
+HashKey::HashKey () noexcept {
+  memcpy(secret, hashSecret, sizeof(secret));
+}
+
+HashKey::HashKey (iu64f seed) noexcept {
+  DSA(sizeof(secret) == sizeof(hashSecret), "");
+  iu64f state = seed;
+  for (size_t i = 0; i != sizeof(secret) / sizeof(*secret); ++i) {
+    secret[i] = hashSecret[i] ^ generateSecretWord(state);
+  }
+}
+
+const HashKey &getProcessHashKey () noexcept {
+  static const HashKey key(createProcessHashSeed());
+  return key;
+}
+
+size_t hash (const iu8f *i, const iu8f *end, const HashKey &key) noexcept {
+  return hashWithSecret(i, offset(i, end), key.secret);
+}
+
+void hashBatch (const iu8f *const *is, const iu8f *const *ends, size_t count, size_t *hs) noexcept {
+  hashBatchWithSecret(is, ends, count, hs, hashSecret);
+}
+
+void hashBatch (const iu8f *const *is, const iu8f *const *ends, size_t count, size_t *hs, const HashKey &key) noexcept {
+  hashBatchWithSecret(is, ends, count, hs, key.secret);
+}
+
+size_t mixHash (size_t h, const HashKey &key) noexcept {
+  return static_cast<size_t>(avalancheStrongly((static_cast<iu64f>(h) ^ key.secret[0]) * hashPrime0 + key.secret[1]));
+}
+
+// Hasher buffers its input until it's known not to be the tail (since the
+// engine treats short inputs and the final stripe specially). Whole stripes
+// are consumed as soon as there is more input after them. The last stripe
+// consumed is always left in (or copied to) the end of the buffer, so that the
+// final stripe can be reassembled if fewer than a stripe's worth of octets
+// remain buffered.
+
+Hasher::Hasher () noexcept : Hasher(hashSecret) {
+}
+
+Hasher::Hasher (const HashKey &key) noexcept : Hasher(key.secret) {
+}
+
+Hasher::Hasher (const iu64f *secret) noexcept : secret(secret), size(0), stripeI(0), bufferedSize(0) {
+  DSA(bufferCapacity % hashStripeSize == 0 && bufferCapacity >= 128 + hashStripeSize, "the buffer must hold whole stripes, a whole short input and a spare stripe");
+  initAccumulators(acc);
+}
+
+void Hasher::update (const iu8f *i, const iu8f *end) noexcept {
+  size_t count = offset(i, end);
+  size += count;
+  if (count <= bufferCapacity - bufferedSize) {
+    if (count != 0) {
+      memcpy(buffer + bufferedSize, i, count);
+      bufferedSize += count;
+    }
+    return;
+  }
+
+  if (bufferedSize != 0) {
+    size_t fillCount = bufferCapacity - bufferedSize;
+    memcpy(buffer + bufferedSize, i, fillCount);
+    i += fillCount;
+    consume(buffer, bufferCapacity / hashStripeSize);
+    bufferedSize = 0;
+  }
+
+  count = offset(i, end);
+  DA(count != 0);
+  if (count > bufferCapacity) {
+    size_t stripeCount = (count - 1) / hashStripeSize;
+    consume(i, stripeCount);
+    i += stripeCount * hashStripeSize;
+    memcpy(buffer + bufferCapacity - hashStripeSize, i - hashStripeSize, hashStripeSize);
+    count = offset(i, end);
+  }
+  memcpy(buffer, i, count);
+  bufferedSize = count;
+}
+
+void Hasher::consume (const iu8f *ptr, size_t stripeCount) noexcept {
+  accumulateStripes(acc, ptr, stripeI, stripeI + stripeCount, secret);
+  stripeI += stripeCount;
+}
+
+size_t Hasher::finish () const noexcept {
+  if (size <= 128) {
+    DA(size == bufferedSize);
+    return hashWithSecret(buffer, size, secret);
+  }
+
+  iu64f finalAcc[4] = {acc[0], acc[1], acc[2], acc[3]};
+  DA(bufferedSize != 0);
+  size_t stripeCount = (bufferedSize - 1) / hashStripeSize;
+  accumulateStripes(finalAcc, buffer, stripeI, stripeI + stripeCount, secret);
+
+  const iu8f *lastStripe = buffer + bufferedSize - hashStripeSize;
+  iu8f b[hashStripeSize];
+  if (bufferedSize < hashStripeSize) {
+    size_t catchUpCount = hashStripeSize - bufferedSize;
+    memcpy(b, buffer + bufferCapacity - catchUpCount, catchUpCount);
+    memcpy(b + catchUpCount, buffer, bufferedSize);
+    lastStripe = b;
+  }
+  return static_cast<size_t>(finishAccumulators(finalAcc, lastStripe, size, secret));
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+// Returns a mask of the top bitCount bits, for testing the gear hash (whose
+// top bits depend on the most octets).
+iu64f createGearMask (iu bitCount) noexcept {
+  return bitCount == 0 ? 0 : ~static_cast<iu64f>(0) << (64 - bitCount);
+}
+
+// Runs the gear hash r_h over [i, end), stopping after the first octet at
+// which it has none of the bits of mask set (if any, setting r_found).
+const iu8f *findGearBoundary (const iu8f *i, const iu8f *end, iu64f mask, iu64f &r_h, bool &r_found) noexcept {
+  const iu64f *table = hashing::rollingHashTable.values;
+  iu64f h = r_h;
+  while (i != end) {
+    h = (h << 1) + table[*(i++)];
+    if ((h & mask) == 0) {
+      r_found = true;
+      break;
+    }
+  }
+  r_h = h;
+  return i;
+}
+
+}
+
+Chunker::Chunker (size_t minSize, size_t averageSize, size_t maxSize) noexcept :
+  minSize(minSize), maxSize(maxSize), averageSize(averageSize), h(0), size(0)
+{
+  DPRE(averageSize != 0 && (averageSize & (averageSize - 1)) == 0, "averageSize must be a power of 2");
+  DPRE(minSize <= averageSize && averageSize <= maxSize, "the sizes must be in order");
+
+  // Boundaries are four times as hard to find before averageSize, and four
+  // times as easy after, which narrows the spread of sizes.
+  iu bitCount = 0;
+  while ((static_cast<size_t>(1) << bitCount) != averageSize) {
+    ++bitCount;
+  }
+  smallMask = createGearMask(std::min(bitCount + 2, 64U));
+  largeMask = createGearMask(bitCount < 2 ? 0 : bitCount - 2);
+}
+
+bool Chunker::scan (const iu8f *&r_i, const iu8f *end) noexcept {
+  const iu8f *i = r_i;
+  bool found = false;
+
+  // Octets more than 64 before minSize can't affect the gear hash at any
+  // boundary, so aren't run through it.
+  if (size + 64 < minSize) {
+    size_t skipCount = std::min(offset(i, end), minSize - 64 - size);
+    i += skipCount;
+    size += skipCount;
+  }
+  if (size < minSize) {
+    const iu64f *table = hashing::rollingHashTable.values;
+    for (size_t n = std::min(offset(i, end), minSize - size); n != 0; --n) {
+      h = (h << 1) + table[*(i++)];
+      ++size;
+    }
+  }
+  if (size >= minSize && size < averageSize) {
+    const iu8f *p = findGearBoundary(i, i + std::min(offset(i, end), averageSize - size), smallMask, h, found);
+    size += offset(i, p);
+    i = p;
+  }
+  if (!found && size >= averageSize && size < maxSize) {
+    const iu8f *p = findGearBoundary(i, i + std::min(offset(i, end), maxSize - size), largeMask, h, found);
+    size += offset(i, p);
+    i = p;
+  }
+  found = found || size == maxSize;
+
+  hasher.update(r_i, i);
+  r_i = i;
+  return found;
+}
+
+Chunker::Chunk Chunker::takeChunk () noexcept {
+  Chunk chunk{size, hasher.finish()};
+  h = 0;
+  size = 0;
+  hasher = Hasher();
+  return chunk;
+}
+
+size_t Chunker::getSize () const noexcept {
+  return size;
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+// Where a key goes in a BloomFilter: the block, and the start and step of the
+// double hashing that picks a bit in each of the block's words (from the top
+// five bits of h1 + i * h2 for word i). The hash value is mixed first, as
+// FastHashable types need not have well-distributed hash values (and so that
+// the positions are independent of those that a flathash::Table takes from
+// the same value).
+struct BloomProbe {
+  size_t blockI;
+  iu32f h1;
+  iu32f h2;
+};
+
+BloomProbe getBloomProbe (size_t h, size_t blockCount) noexcept {
+  iu64f m1 = hashing::mum(static_cast<iu64f>(h) ^ hashing::hashPrime3, hashing::hashPrime2);
+  iu64f m2 = hashing::mum(static_cast<iu64f>(h) ^ hashing::hashPrime1, hashing::hashPrime0);
+  return BloomProbe{
+    static_cast<size_t>(((m1 >> 32) * static_cast<iu64f>(blockCount)) >> 32), static_cast<iu32f>(m1), static_cast<iu32f>(m2)
+  };
+}
+
+#if defined(ARCH_X86) && defined(__SSE2__)
+// Gets 1 << (x >> 27) for each lane, by building the float 2^(x >> 27) and
+// converting it (2^31 is out of range, which gives 0x80000000: the mask
+// wanted).
+__m128i createBloomMasks (__m128i x) noexcept {
+  __m128i exponents = _mm_slli_epi32(_mm_srli_epi32(x, 27), 23);
+  return _mm_cvttps_epi32(_mm_castsi128_ps(_mm_add_epi32(exponents, _mm_set1_epi32(0x3F800000))));
+}
+
+void createBloomMasks (const BloomProbe &probe, __m128i &r_lo, __m128i &r_hi) noexcept {
+  iu32f h2 = probe.h2;
+  __m128i lo = _mm_add_epi32(
+    _mm_set1_epi32(static_cast<int>(probe.h1)),
+    _mm_set_epi32(static_cast<int>(h2 * 3), static_cast<int>(h2 * 2), static_cast<int>(h2), 0)
+  );
+  __m128i hi = _mm_add_epi32(lo, _mm_set1_epi32(static_cast<int>(h2 * 4)));
+  r_lo = createBloomMasks(lo);
+  r_hi = createBloomMasks(hi);
+}
+#endif
+
+}
+
+BloomFilter::BloomFilter (size_t expectedCount, double falsePositiveRate) : BloomFilter(getBlockCount(expectedCount, falsePositiveRate)) {
+}
+
+BloomFilter::BloomFilter (size_t blockCount) : blocks(new Block[blockCount]()), blockCount(blockCount) {
+}
+
+size_t BloomFilter::getBlockCount (size_t expectedCount, double falsePositiveRate) {
+  DPRE(falsePositiveRate > 0.0 && falsePositiveRate < 1.0, "the false positive rate must be a probability");
+
+  // The false positive rate rises with the load, so find the load that gives
+  // the rate wanted by bisection.
+  double lo = 0.0, hi = 256.0;
+  for (iu i = 0; i != 64; ++i) {
+    double mid = (lo + hi) / 2.0;
+    (getFalsePositiveRate(mid) <= falsePositiveRate ? lo : hi) = mid;
+  }
+  double count = std::ceil(static_cast<double>(expectedCount) / std::max(lo, 1.0 / 1024.0));
+  if (count > static_cast<double>(maxBlockCount)) {
+    throw std::length_error("Bloom filter would have too many blocks");
+  }
+  return std::max(static_cast<size_t>(1), static_cast<size_t>(count));
+}
+
+void BloomFilter::insertHash (size_t h) noexcept {
+  BloomProbe probe = getBloomProbe(h, blockCount);
+  iu32f *words = blocks[probe.blockI].words;
+  #if defined(ARCH_X86) && defined(__SSE2__)
+  __m128i lo, hi;
+  createBloomMasks(probe, lo, hi);
+  auto ptr = reinterpret_cast<__m128i *>(words);
+  _mm_store_si128(ptr, _mm_or_si128(_mm_load_si128(ptr), lo));
+  _mm_store_si128(ptr + 1, _mm_or_si128(_mm_load_si128(ptr + 1), hi));
+  #else
+  for (iu i = 0; i != 8; ++i) {
+    words[i] |= static_cast<iu32f>(1) << ((probe.h1 + i * probe.h2) >> 27);
+  }
+  #endif
+}
+
+bool BloomFilter::mayContainHash (size_t h) const noexcept {
+  BloomProbe probe = getBloomProbe(h, blockCount);
+  const iu32f *words = blocks[probe.blockI].words;
+  #if defined(ARCH_X86) && defined(__SSE2__)
+  __m128i lo, hi;
+  createBloomMasks(probe, lo, hi);
+  auto ptr = reinterpret_cast<const __m128i *>(words);
+  __m128i missing = _mm_or_si128(_mm_andnot_si128(_mm_load_si128(ptr), lo), _mm_andnot_si128(_mm_load_si128(ptr + 1), hi));
+  return _mm_movemask_epi8(_mm_cmpeq_epi32(missing, _mm_setzero_si128())) == 0xFFFF;
+  #else
+  iu32f missing = 0;
+  for (iu i = 0; i != 8; ++i) {
+    missing |= ~words[i] & (static_cast<iu32f>(1) << ((probe.h1 + i * probe.h2) >> 27));
+  }
+  return missing == 0;
+  #endif
+}
+
+void BloomFilter::clear () noexcept {
+  std::fill(blocks.get(), blocks.get() + blockCount, Block());
+}
+
+void BloomFilter::merge (const BloomFilter &o) noexcept {
+  DPRE(o.blockCount == blockCount, "the filters must be the same size");
+
+  for (size_t i = 0; i != blockCount; ++i) {
+    for (iu j = 0; j != 8; ++j) {
+      blocks[i].words[j] |= o.blocks[i].words[j];
+    }
+  }
+}
+
+size_t BloomFilter::getSize () const noexcept {
+  return blockCount * sizeof(Block);
+}
+
+double BloomFilter::getFalsePositiveRate (size_t count) const noexcept {
+  return getFalsePositiveRate(static_cast<double>(count) / static_cast<double>(blockCount));
+}
+
+size_t BloomFilter::getWrittenSize () const noexcept {
+  return getIeuSize(formatVersion) + getIeuSize(blockCount) + getSize();
+}
+
+// The number of keys in a block is Poisson-distributed. Given j keys in the
+// block, a bit in a word is set with probability 1 - (31/32)^j, and a false
+// positive needs all 8 of the bits probed to be set.
+double BloomFilter::getFalsePositiveRate (double keysPerBlock) noexcept {
+  double rate = 0.0;
+  double p = std::exp(-keysPerBlock);
+  double end = keysPerBlock + 12.0 * std::sqrt(keysPerBlock) + 16.0;
+  for (double j = 0.0; j < end; ++j) {
+    rate += p * std::pow(1.0 - std::pow(31.0 / 32.0, j), 8.0);
+    p *= keysPerBlock / (j + 1.0);
+  }
+  return rate;
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+// Each vector of differences is decoded from zigzag form, summed across its
+// lanes (by adding itself shifted by one lane, then by two) and added to the
+// last value of the vector before, which is kept broadcast.
+void addZigzagDeltas (iu32f *values, size_t count) noexcept {
+  size_t i = 1;
+  #if defined(ARCH_X86) && defined(__SSE2__)
+  __m128i one = _mm_set1_epi32(1);
+  __m128i last = _mm_set1_epi32(static_cast<int>(values[0]));
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+    v = _mm_xor_si128(_mm_srli_epi32(v, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(v, one)));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi32(v, last);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(values + i), v);
+    last = _mm_shuffle_epi32(v, 0xFF);
+  }
+  #endif
+  addZigzagDeltasScalar(values + i - 1, count - (i - 1));
+}
+
+void addZigzagDeltas (iu64f *values, size_t count) noexcept {
+  size_t i = 1;
+  #if defined(ARCH_X86) && defined(__SSE2__)
+  __m128i one = _mm_set1_epi64x(1);
+  __m128i last = _mm_set1_epi64x(static_cast<long long>(values[0]));
+  for (; i + 2 <= count; i += 2) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+    v = _mm_xor_si128(_mm_srli_epi64(v, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(v, one)));
+    v = _mm_add_epi64(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi64(v, last);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(values + i), v);
+    last = _mm_unpackhi_epi64(v, v);
+  }
+  #endif
+  addZigzagDeltasScalar(values + i - 1, count - (i - 1));
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+OctetSource::OctetSource (size_t capacity) :
+  buffer(new iu8f[capacity]), capacity(capacity), ptr(buffer.get()), end(buffer.get()), exhausted(false)
+{
+  if (capacity < static_cast<size_t>(numeric_limits<iu64f>::max_ie_octets)) {
+    throw std::invalid_argument("the capacity must be enough for the longest variable-length integer");
+  }
+}
+
+OctetSource::~OctetSource () noexcept {
+}
+
+bool OctetSource::refill () {
+  iu8f *b = buffer.get();
+  size_t size = offset(ptr, end);
+  if (exhausted || size == capacity) {
+    return false;
+  }
+
+  memmove(b, ptr, size);
+  ptr = b;
+  end = b + size;
+  size_t supplied = supply(b + size, capacity - size);
+  DA(supplied <= capacity - size);
+  if (supplied == 0) {
+    exhausted = true;
+    return false;
+  }
+  end += supplied;
+  return true;
+}
+
+bool OctetSource::isExhausted () {
+  return ptr == end && !refill();
+}
+
+// Runs longer than the buffer are supplied straight to out.
+size_t OctetSource::read (iu8f *out, size_t size) {
+  size_t copied = std::min(size, offset(ptr, end));
+  memcpy(out, ptr, copied);
+  ptr += copied;
+  while (copied != size && !exhausted) {
+    size_t left = size - copied;
+    if (left >= capacity) {
+      size_t supplied = supply(out + copied, left);
+      if (supplied == 0) {
+        exhausted = true;
+      }
+      copied += supplied;
+    } else if (refill()) {
+      size_t part = std::min(left, offset(ptr, end));
+      memcpy(out + copied, ptr, part);
+      ptr += part;
+      copied += part;
+    }
+  }
+  return copied;
+}
+
+OctetSink::OctetSink (size_t capacity) :
+  buffer(new iu8f[capacity]), capacity(capacity), ptr(buffer.get())
+{
+  if (capacity < static_cast<size_t>(numeric_limits<iu64f>::max_ie_octets)) {
+    throw std::invalid_argument("the capacity must be enough for the longest variable-length integer");
+  }
+}
+
+OctetSink::~OctetSink () noexcept {
+}
+
+void OctetSink::flush () {
+  iu8f *b = buffer.get();
+  if (ptr != b) {
+    size_t size = offset(b, ptr);
+    ptr = b;
+    consume(b, size);
+  }
+}
+
+void OctetSink::write (const iu8f *i, const iu8f *end) {
+  size_t size = offset(i, end);
+  if (size <= offset(ptr, getEnd())) {
+    memcpy(ptr, i, size);
+    ptr += size;
+    return;
+  }
+
+  flush();
+  if (size >= capacity) {
+    consume(i, size);
+  } else {
+    memcpy(ptr, i, size);
+    ptr += size;
+  }
+}
+
+FileOctetSource::FileOctetSource (FILE *handle, size_t capacity) : OctetSource(capacity), handle(handle) {
+}
+
+size_t FileOctetSource::supply (iu8f *out, size_t size) {
+  size_t r = fread(out, 1, size, handle);
+  if (r == 0 && ferror(handle)) {
+    throw PlainException(u8"the file could not be read");
   }
   return r;
 }
 
+FileOctetSink::FileOctetSink (FILE *handle, size_t capacity) : OctetSink(capacity), handle(handle) {
+}
+
+FileOctetSink::~FileOctetSink () noexcept {
+  try {
+    flush();
+  } catch (...) {
+    // The octets are lost.
+  }
+}
+
+void FileOctetSink::consume (const iu8f *ptr, size_t size) {
+  if (fwrite(ptr, 1, size, handle) != size) {
+    throw PlainException(u8"the file could not be written");
+  }
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+#ifdef OS_POSIX
+namespace {
+
+int getAdvice (MappedFile::Access access) noexcept {
+  switch (access) {
+    case MappedFile::Access::sequential:
+      return MADV_SEQUENTIAL;
+    case MappedFile::Access::random:
+      return MADV_RANDOM;
+    default:
+      return MADV_NORMAL;
+  }
+}
+
+}
+
+// An empty file can't be mapped, so it has a null ptr.
+MappedFile::MappedFile (const char *pathName, Access access) : ptr(nullptr), size(0) {
+  int fd = open(pathName, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw PlainException(u8"the file could not be opened");
+  }
+  finally([&] () {
+    close(fd);
+  });
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    throw PlainException(u8"the file could not be opened");
+  }
+  if (st.st_size == 0) {
+    return;
+  }
+  if (static_cast<std::make_unsigned<off_t>::type>(st.st_size) > std::numeric_limits<size_t>::max()) {
+    throw PlainException(u8"the file is too large to be mapped");
+  }
+
+  auto s = static_cast<size_t>(st.st_size);
+  void *p = mmap(nullptr, s, PROT_READ, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    throw PlainException(u8"the file could not be mapped");
+  }
+  ptr = static_cast<const iu8f *>(p);
+  size = s;
+  advise(access);
+}
+
+MappedFile::MappedFile (MappedFile &&o) noexcept : ptr(o.ptr), size(o.size) {
+  o.ptr = nullptr;
+  o.size = 0;
+}
+
+MappedFile::~MappedFile () noexcept {
+  if (ptr) {
+    munmap(const_cast<iu8f *>(ptr), size);
+  }
+}
+
+void MappedFile::advise (Access access) noexcept {
+  if (ptr) {
+    madvise(const_cast<iu8f *>(ptr), size, getAdvice(access));
+  }
+}
+
+// madvise() needs a page-aligned start, and the mapping itself is one.
+void MappedFile::prefetch (const iu8f *i, const iu8f *end) noexcept {
+  DPRE(ptr <= i && i <= end && end <= ptr + size, "the octets must be within the file");
+  if (i == end) {
+    return;
+  }
+
+  static const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t start = offset(ptr, i) / pageSize * pageSize;
+  madvise(const_cast<iu8f *>(ptr + start), offset(ptr + start, end), MADV_WILLNEED);
+}
+#endif
+
 /* -----------------------------------------------------------------------------
 ----------------------------------------------------------------------------- */
 const char *UException::what () const noexcept {
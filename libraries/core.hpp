@@ -15,6 +15,18 @@
 #include <functional>
 #include <cstddef>
 #include <stdexcept>
+#include <shared_mutex>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <ranges>
+#include <bit>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 #define _VERSION_EXPORT_NAME_(LIB, MAJ, MIN) _ ## LIB ## _ ## MAJ ## _ ## MIN ## _
 #define _version_(LIB, MAJ, MIN) extern const bool _VERSION_EXPORT_NAME_(LIB, MAJ, MIN) = false;
@@ -469,10 +481,20 @@ template<std::unsigned_integral _i, core::OutputIterator<iu8f> _OutputIterator>
   variable-length format.
 */
 template<std::signed_integral _i, core::OutputIterator<iu8f> _OutputIterator> void writeIes (_OutputIterator &r_ptr, _i value) noexcept(noexcept(*(r_ptr++)));
+/**
+  Returns the number of octets that writeIeu() writes for {@p value}.
+*/
+template<std::unsigned_integral _i> constexpr size_t getIeuSize (_i value) noexcept;
+/**
+  Returns the number of octets that writeIes() writes for {@p value}.
+*/
+template<std::signed_integral _i> constexpr size_t getIesSize (_i value) noexcept;
 
 /**
   Reads a value of type {@p _i} from the given octet stream in an unsigned
-  variable-length format, if possible.
+  variable-length format, if possible. Where the stream is a pointer to
+  contiguous octets, values are read a word at a time away from its end, so
+  every octet in [{@p r_ptr}, {@p ptrEnd}) may be read.
 */
 template<
   std::unsigned_integral _i, core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator
@@ -488,7 +510,8 @@ template<
 } _i readValidIeu (_InputIterator &r_ptr) noexcept;
 /**
   Reads a value of type {@p _i} from the given octet stream in a signed
-  variable-length format, if possible.
+  variable-length format, if possible. As with readIeu(), every octet in
+  [{@p r_ptr}, {@p ptrEnd}) may be read.
 */
 template<
   std::signed_integral _i, core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator
@@ -503,6 +526,212 @@ template<
   {*(i++)} noexcept;
 } _i readValidIes (_InputIterator &r_ptr) noexcept;
 
+/**
+  Reads {@p count} values of type {@p _i} from the given octet stream in the
+  unsigned variable-length format into {@p out}, giving the same results (and
+  throwing the same exceptions, having read the same values) as calling
+  readIeu() {@p count} times. Runs of short values are decoded many at a time
+  (by SIMD where the executing CPU supports it).
+*/
+template<std::unsigned_integral _i> void readIeuArray (const iu8f *&r_ptr, const iu8f *ptrEnd, _i *out, size_t count);
+/**
+  Reads {@p count} values of type {@p _i} from the given octet stream in the
+  signed variable-length format into {@p out}, as readIeuArray() does for the
+  unsigned one.
+*/
+template<std::signed_integral _i> void readIesArray (const iu8f *&r_ptr, const iu8f *ptrEnd, _i *out, size_t count);
+/**
+  Skips {@p count} values in the unsigned (or signed) variable-length format in
+  the given octet stream without decoding them, finding the octets that end
+  values many at a time (by SIMD where the executing CPU supports it).
+
+  @throw PlainException if the stream holds fewer values (having been skipped
+  to its end).
+*/
+void skipIeu (const iu8f *&r_ptr, const iu8f *ptrEnd, size_t count);
+/**
+  Returns the number of values in the unsigned (or signed) variable-length
+  format that end in [{@p ptr}, {@p ptrEnd}), without decoding them.
+*/
+size_t countIeu (const iu8f *ptr, const iu8f *ptrEnd) noexcept;
+/**
+  The implementations of the skipping done by skipIeu() and countIeu() (the
+  SIMD ones also needing POPCNT). All give identical results; by default, the
+  best one supported by the executing CPU is used (unless the environment
+  variable {@c CORE_SKIP_KERNEL} names another supported one e.g.
+  {@c CORE_SKIP_KERNEL=scalar}).
+*/
+enum class SkipKernel {
+  scalar, sse2, avx2
+};
+
+/**
+  Returns whether the given kernel can be used on the executing CPU.
+*/
+bool isSkipKernelSupported (SkipKernel kernel) noexcept;
+/**
+  Makes skipIeu() and countIeu() use the given kernel, if it is supported.
+
+  @return whether the kernel is now in use.
+*/
+bool setSkipKernel (SkipKernel kernel) noexcept;
+/**
+  Returns the kernel that skipIeu() and countIeu() are using.
+*/
+SkipKernel getSkipKernel () noexcept;
+
+/**
+  Returns the number of octets that writeIeuArray() writes for the
+  {@p count} values at {@p in}.
+*/
+template<std::unsigned_integral _i> size_t getIeuArraySize (const _i *in, size_t count) noexcept;
+/**
+  Returns the number of octets that writeIesArray() writes for the
+  {@p count} values at {@p in}.
+*/
+template<std::signed_integral _i> size_t getIesArraySize (const _i *in, size_t count) noexcept;
+/**
+  Writes the {@p count} values at {@p in} to the given octet buffer (which
+  must have room for getIeuArraySize() octets before {@p ptrEnd}) in the
+  unsigned variable-length format, giving the same octets as calling writeIeu()
+  {@p count} times. Each value is built in a register and written with one
+  wide store (while the buffer has room for one).
+*/
+template<std::unsigned_integral _i> void writeIeuArray (iu8f *&r_ptr, const iu8f *ptrEnd, const _i *in, size_t count) noexcept;
+/**
+  Writes the {@p count} values at {@p in} to the given octet buffer in the
+  signed variable-length format, as writeIeuArray() does for the unsigned one.
+*/
+template<std::signed_integral _i> void writeIesArray (iu8f *&r_ptr, const iu8f *ptrEnd, const _i *in, size_t count) noexcept;
+/**
+  Appends the {@p count} values at {@p in} to the given octet container (e.g.
+  a {@c std::vector<iu8f>}) in the unsigned variable-length format, growing it
+  once.
+*/
+template<typename _Octets, std::unsigned_integral _i> requires requires (_Octets &r_octets, size_t size) {
+  r_octets.resize(size);
+  {r_octets.data()} -> std::same_as<iu8f *>;
+} void writeIeuArray (_Octets &r_octets, const _i *in, size_t count);
+/**
+  Appends the {@p count} values at {@p in} to the given octet container in the
+  signed variable-length format, growing it once.
+*/
+template<typename _Octets, std::signed_integral _i> requires requires (_Octets &r_octets, size_t size) {
+  r_octets.resize(size);
+  {r_octets.data()} -> std::same_as<iu8f *>;
+} void writeIesArray (_Octets &r_octets, const _i *in, size_t count);
+
+/**
+  Writes a value of type {@p _i} to the given octet stream in an unsigned
+  prefix-length format, in which the number of octets is given by the number
+  of trailing zero bits of the first octet (so that a value can be read
+  without looking at each of its octets in turn).
+*/
+template<std::unsigned_integral _i, core::OutputIterator<iu8f> _OutputIterator> void writeIpu (_OutputIterator &r_ptr, _i value) noexcept(noexcept(*(r_ptr++)));
+/**
+  Writes a value of type {@p _i} to the given octet stream in a signed
+  prefix-length format (the unsigned one, of the zigzag encoding of the value).
+*/
+template<std::signed_integral _i, core::OutputIterator<iu8f> _OutputIterator> void writeIps (_OutputIterator &r_ptr, _i value) noexcept(noexcept(*(r_ptr++)));
+/**
+  Reads a value of type {@p _i} from the given octet stream in an unsigned
+  prefix-length format, if possible.
+
+  @throw PlainException if the stream is truncated (or std::overflow_error if
+  the value is too big for {@p _i}).
+*/
+template<
+  std::unsigned_integral _i, core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator
+> _i readIpu (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd);
+/**
+  Reads a value of type {@p _i} from the given octet stream in an unsigned
+  prefix-length format.
+*/
+template<
+  std::unsigned_integral _i, core::InputIterator<iu8f> _InputIterator
+> requires requires (_InputIterator i) {
+  {*(i++)} noexcept;
+} _i readValidIpu (_InputIterator &r_ptr) noexcept;
+/**
+  Reads a value of type {@p _i} from the given octet stream in a signed
+  prefix-length format, if possible.
+
+  @throw PlainException if the stream is truncated (or std::overflow_error if
+  the value is out of the range of {@p _i}).
+*/
+template<
+  std::signed_integral _i, core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator
+> _i readIps (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd);
+/**
+  Reads a value of type {@p _i} from the given octet stream in a signed
+  prefix-length format.
+*/
+template<
+  std::signed_integral _i, core::InputIterator<iu8f> _InputIterator
+> requires requires (_InputIterator i) {
+  {*(i++)} noexcept;
+} _i readValidIps (_InputIterator &r_ptr) noexcept;
+/**
+  Returns the number of octets that writeIpu() writes for {@p value}.
+*/
+template<std::unsigned_integral _i> constexpr size_t getIpuSize (_i value) noexcept;
+/**
+  Returns the number of octets that writeIps() writes for {@p value}.
+*/
+template<std::signed_integral _i> constexpr size_t getIpsSize (_i value) noexcept;
+
+/**
+  Reads {@p count} values from the given octet stream in the unsigned
+  variable-length format and writes them to {@p r_out} in the unsigned
+  prefix-length format.
+
+  @throw as readIeu() (of {@c iu64f}s) does.
+*/
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIeuToIpu (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count);
+/**
+  Reads {@p count} values from the given octet stream in the unsigned
+  prefix-length format and writes them to {@p r_out} in the unsigned
+  variable-length format.
+
+  @throw as readIpu() (of {@c iu64f}s) does.
+*/
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIpuToIeu (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count);
+/**
+  Reads {@p count} values from the given octet stream in the signed
+  variable-length format and writes them to {@p r_out} in the signed
+  prefix-length format.
+
+  @throw as readIes() (of {@c is64f}s) does.
+*/
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIesToIps (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count);
+/**
+  Reads {@p count} values from the given octet stream in the signed
+  prefix-length format and writes them to {@p r_out} in the signed
+  variable-length format.
+
+  @throw as readIps() (of {@c is64f}s) does.
+*/
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIpsToIes (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count);
+
+/**
+  The implementations of the bulk of the work of readIeuArray() and
+  readIesArray(), which decode values from [{@p r_ptr}, {@p ptrEnd}) into
+  {@p out} for as long as they can do so quickly (leaving anything awkward,
+  including invalid input, to the caller), returning the number decoded.
+*/
+size_t readIeuBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, iu32f *out, size_t count) noexcept;
+size_t readIeuBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, iu64f *out, size_t count) noexcept;
+size_t readIesBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, is32f *out, size_t count) noexcept;
+size_t readIesBlock (const iu8f *&r_ptr, const iu8f *ptrEnd, is64f *out, size_t count) noexcept;
+
 }
 
 /* -----------------------------------------------------------------------------
@@ -631,191 +860,1766 @@ template<typename _I> requires requires (const _I &i) {
 /* -----------------------------------------------------------------------------
    Hashing
 ----------------------------------------------------------------------------- */
-namespace core {
+namespace core::hashing {
 
 /**
-  Hashes a sequence of octets.
+  The secret that unkeyed hashing uses (and that keys are derived from).
 */
-size_t hash (const iu8f *i, const iu8f *end) noexcept;
+inline constexpr iu64f hashSecret[16] = {
+  0xAF9A1AD602429923ULL, 0x0137A87EFEC4C5B7ULL, 0x22AEBA39CA959BD3ULL, 0x314C8CA4E49FDFEBULL,
+  0x54FCF0AB781EBF87ULL, 0x31E45C05241EDFC9ULL, 0x9B75278D4F59172BULL, 0x37F2912A23E04595ULL,
+  0xBB75F81DB8D69C4BULL, 0x3545F79EDB7E2A15ULL, 0x6F7B11BC32E6C8B5ULL, 0xF9AF2E8913A5C773ULL,
+  0x812B8E5F07F84CB9ULL, 0xC251BE05271D0CBFULL, 0x4749766CCA2FE279ULL, 0x5753C328CC9AC123ULL
+};
+
+inline constexpr iu64f hashPrime0 = 0x9E3779B185EBCA87ULL;
+inline constexpr iu64f hashPrime1 = 0xC2B2AE3D27D4EB4FULL;
+inline constexpr iu64f hashPrime2 = 0x165667B19E3779F9ULL;
+inline constexpr iu64f hashPrime3 = 0x9FB21C651E98DF25ULL;
+inline constexpr iu64f hashPrime32 = 0x9E3779B1U;
+
+inline constexpr size_t hashStripeSize = 32;
+inline constexpr size_t hashBlockStripeCount = 16;
 
 /**
-  Implementation of {@c size_t hashSlow (const _T &)}) that leans on a
-  corresponding member function.
+  One-octet types, whose sequences can be hashed in constant expressions.
 */
-template<typename _T> requires requires (const _T &o) {
-  {o.hashSlow()} -> std::same_as<size_t>;
-} size_t hashSlow (const _T &o) noexcept_auto_return(
-  o.hashSlow()
-)
+template<typename _c> concept Octet = sizeof(_c) == 1 && (std::integral<_c> || std::same_as<_c, std::byte>);
+
 /**
-  Implementation of {@c size_t hashFast (const _T &) noexcept}) that leans on a
-  corresponding member function.
+  The primitives of the engine (see core.ipp), which can all be evaluated at
+  compile time (except that the bulk of the work on long inputs is done by the
+  kernel chosen for the executing CPU when not).
 */
-template<typename _T> requires requires (const _T &o) {
-  {o.hashFast()} noexcept -> std::same_as<size_t>;
-} size_t hashFast (const _T &o) noexcept {
-  return o.hashFast();
+template<Octet _c> constexpr iu64f read64 (const _c *ptr) noexcept;
+template<Octet _c> constexpr iu64f read32 (const _c *ptr) noexcept;
+constexpr iu64f rotl64 (iu64f value, iu sh) noexcept;
+constexpr iu64f mum (iu64f l, iu64f r) noexcept;
+constexpr iu64f avalanche (iu64f h) noexcept;
+constexpr iu64f avalancheStrongly (iu64f h) noexcept;
+template<Octet _c> constexpr iu64f mix16 (const _c *ptr, const iu64f *key) noexcept;
+template<Octet _c> constexpr iu64f hash0To3 (const _c *ptr, size_t size, const iu64f *secret) noexcept;
+template<Octet _c> constexpr iu64f hash4To8 (const _c *ptr, size_t size, const iu64f *secret) noexcept;
+template<Octet _c> constexpr iu64f hash9To16 (const _c *ptr, size_t size, const iu64f *secret) noexcept;
+template<Octet _c> constexpr iu64f hash0To16 (const _c *ptr, size_t size, const iu64f *secret) noexcept;
+template<Octet _c> constexpr iu64f hash17To128 (const _c *ptr, size_t size, const iu64f *secret) noexcept;
+template<Octet _c> constexpr void accumulateStripe (iu64f *acc, const _c *ptr, const iu64f *key) noexcept;
+constexpr void scrambleAccumulators (iu64f *acc, const iu64f *key) noexcept;
+template<Octet _c> constexpr void accumulateStripesScalar (iu64f *acc, const _c *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept;
+/**
+  Consumes the stripes [{@p stripeI}, {@p stripeEnd}) with the kernel in use
+  (see ::HashKernel).
+*/
+void accumulateStripes (iu64f *acc, const iu8f *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept;
+constexpr void initAccumulators (iu64f *acc) noexcept;
+template<Octet _c> constexpr iu64f finishAccumulators (iu64f *acc, const _c *lastStripe, size_t size, const iu64f *secret) noexcept;
+template<Octet _c> constexpr iu64f hashLong (const _c *ptr, size_t size, const iu64f *secret) noexcept;
+template<Octet _c> constexpr size_t hashWithSecret (const _c *ptr, size_t size, const iu64f *secret) noexcept;
+/**
+  Does nothing, but isn't constexpr: it is called while constructing a
+  HashedLiteral from a bad literal, so that the construction fails to compile.
+*/
+void literalMustEndWithItsOnlyNullCharacter () noexcept;
+
 }
 
+namespace core {
+
 /**
-  Exposes a hash value (from {@c size_t hashSlow (const _T &)}) that may be
-  non-trivial to calculate.
+  A key for hashing, which makes hash values unpredictable to anyone who doesn't
+  know it (so that they cannot choose inputs that collide, though this is no
+  substitute for a cryptographic MAC).
 */
-template<typename _T> concept SlowHashable = requires (const _T &o) {
-  {hashSlow(o)} -> std::same_as<size_t>;
+class HashKey {
+  prv iu64f secret[16];
+
+  /**
+    Constructs the key that unkeyed hashing uses.
+  */
+  pub HashKey () noexcept;
+  /**
+    Constructs a key derived from the given seed (so that the same seed always
+    gives the same hash values).
+  */
+  pub explicit HashKey (iu64f seed) noexcept;
+
+  friend size_t hash (const iu8f *i, const iu8f *end, const HashKey &key) noexcept;
+  friend size_t mixHash (size_t h, const HashKey &key) noexcept;
+  friend void hashBatch (const iu8f *const *is, const iu8f *const *ends, size_t count, size_t *hs, const HashKey &key) noexcept;
+  friend class Hasher;
 };
+
 /**
-  Exposes a hash value (from {@c size_t hashFast (const _T &) noexcept}) that is
-  so trivial to calculate that it does not need to be persistently cached.
+  Returns the key for this process, which is created from a random seed on
+  first use (unless the environment variable {@c CORE_HASH_SEED} gives the seed
+  to use e.g. {@c CORE_HASH_SEED=0x1234}). If {@c CORE_HASH_SEED} is set but
+  isn't a number (in the form taken by {@c strtoull()}), the process is
+  terminated.
 */
-template<typename _T> concept FastHashable = requires (const _T &o) {
-  {hashFast(o)} noexcept -> std::same_as<size_t>;
+const HashKey &getProcessHashKey () noexcept;
+
+/**
+  Hashes a sequence of octets. The result depends only on the values of the
+  octets (not on their alignment) and is well distributed over all of its bits.
+  This can be evaluated at compile time, giving the same result as at run time.
+*/
+template<hashing::Octet _c> constexpr size_t hash (const _c *i, const _c *end) noexcept;
+/**
+  Hashes a sequence of octets under the given key, at the same cost as unkeyed
+  hashing.
+*/
+size_t hash (const iu8f *i, const iu8f *end, const HashKey &key) noexcept;
+/**
+  Hashes each of the {@p count} sequences of octets
+  [{@c is[n]}, {@c ends[n]}), storing the values (as from ::hash()) in
+  {@c hs[n]}. Independent inputs are hashed together, for better throughput than
+  hashing them one by one.
+*/
+void hashBatch (const iu8f *const *is, const iu8f *const *ends, size_t count, size_t *hs) noexcept;
+void hashBatch (const iu8f *const *is, const iu8f *const *ends, size_t count, size_t *hs, const HashKey &key) noexcept;
+/**
+  Scrambles a hash value under the given key. Distinct values stay distinct.
+*/
+size_t mixHash (size_t h, const HashKey &key) noexcept;
+
+/**
+  The implementations of the bulk of the work of ::hash() (for long inputs).
+  All give identical results; by default, the best one supported by the
+  executing CPU is used (unless the environment variable {@c CORE_HASH_KERNEL}
+  names another supported one e.g. {@c CORE_HASH_KERNEL=scalar}).
+*/
+enum class HashKernel {
+  scalar, sse2, avx2
 };
 
 /**
-  Implementation of {@c size_t hashSlow (const std::reference_wrapper<_T> &)})
-  that leans on the referenced object.
+  Returns whether the given kernel can be used on the executing CPU.
 */
-template<SlowHashable _T> size_t hashSlow (const std::reference_wrapper<_T> &o) noexcept_auto_return(
-  hashSlow(o.get())
-)
+bool isHashKernelSupported (HashKernel kernel) noexcept;
 /**
-  Implementation of {@c size_t hashFast (const std::reference_wrapper<_T> &) noexcept})
-  that leans on the referenced object.
+  Makes ::hash() use the given kernel, if it is supported.
+
+  @return whether the kernel is now in use.
 */
-template<FastHashable _T> size_t hashFast (const std::reference_wrapper<_T> &o) noexcept {
-  return hashFast(o.get());
-}
+bool setHashKernel (HashKernel kernel) noexcept;
+/**
+  Returns the kernel that ::hash() is using.
+*/
+HashKernel getHashKernel () noexcept;
 
-template<typename _T> class SlowHashWrapper {
-  prv _T o;
-  prv size_t h;
+/**
+  Instances hash a sequence of octets supplied in pieces, giving the same value
+  as ::hash() would for the whole sequence (however it is split up).
+*/
+class Hasher {
+  pub static constexpr size_t bufferCapacity = 256;
 
+  prv const iu64f *secret;
+  prv iu64f acc[4];
+  prv size_t size;
+  prv size_t stripeI;
+  prv size_t bufferedSize;
+  prv iu8f buffer[bufferCapacity];
+
+  pub Hasher () noexcept;
   /**
-    Constructs the wrapped object in-place (by calling the constructor for
-    {@c _T} with the given arguments forwarded) and stores its hash.
+    Constructs a Hasher that hashes under the given key (which must remain valid
+    for the life of the Hasher).
   */
-  pub template<typename ..._Ts> requires requires (_Ts &&...ts) {
-    {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
-  } explicit SlowHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)) && noexcept(hashSlow(o)));
+  pub explicit Hasher (const HashKey &key) noexcept;
+  prv explicit Hasher (const iu64f *secret) noexcept;
 
   /**
-    Returns a reference to the wrapped object.
+    Appends the octets [{@p i}, {@p end}) to the sequence.
   */
-  pub const _T &get () const noexcept;
+  pub void update (const iu8f *i, const iu8f *end) noexcept;
   /**
-    Returns an object moved to from the wrapped object.
+    Appends the octets of {@p value} (in little-endian order) to the sequence.
   */
-  pub _T release () && noexcept;
-
+  pub template<std::integral _i> void update (_i value) noexcept;
   /**
-    Returns the stored hash value of the wrapped object.
+    Appends the contents of {@p o} to the sequence (via its
+    {@c void hashSlow (Hasher &) const} member function).
   */
-  pub size_t hashFast () const noexcept;
+  pub template<typename _T> requires requires (const _T &o, Hasher &r_hasher) {
+    o.hashSlow(r_hasher);
+  } void update (const _T &o) noexcept(noexcept(o.hashSlow(std::declval<Hasher &>())));
+  prv void consume (const iu8f *ptr, size_t stripeCount) noexcept;
+
   /**
-    Compares two instances for equality by their wrapped objects.
+    Returns the hash value of the sequence so far.
   */
-  pub bool operator== (const SlowHashWrapper<_T> &r) const noexcept(noexcept(r.get() == r.get()));
+  pub size_t finish () const noexcept;
 };
 
-template<typename _T> class FastHashWrapper {
-  prv _T o;
+namespace hashing {
+
+/**
+  The values that RollingHash and Chunker give to octets.
+*/
+struct RollingHashTable {
+  iu64f values[256];
+};
+constexpr RollingHashTable createRollingHashTable () noexcept;
+
+}
+
+/**
+  Instances hash a window of the last {@c windowSize} octets of a sequence
+  (by cyclic polynomial i.e. 'buzhash'), sliding it along by one octet in
+  constant time. Equal windows give equal values (whatever came before them),
+  but the values are not well distributed over all of their bits in the way
+  that those of ::hash() are.
+*/
+class RollingHash {
+  prv size_t windowSize;
+  prv iu64f h;
+
+  pub explicit RollingHash (size_t windowSize) noexcept;
 
   /**
-    Constructs the wrapped object in-place (by calling the constructor for
-    {@c _T} with the given arguments forwarded).
+    Appends {@p in} to the window (which should be done {@c windowSize} times
+    before the window is slid).
   */
-  pub template<typename ..._Ts> requires requires (_Ts &&...ts) {
-    {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
-  } explicit FastHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)));
+  pub void push (iu8f in) noexcept;
+  /**
+    Slides the window along by one octet: appends {@p in} and drops {@p out}
+    (which must be the octet pushed {@c windowSize} octets before).
+  */
+  pub void roll (iu8f out, iu8f in) noexcept;
+  /**
+    Returns the hash value of the window.
+  */
+  pub size_t get () const noexcept;
+};
 
+/**
+  Splits a sequence of octets into chunks at boundaries that depend on the
+  content (found with a 'gear' rolling hash over the last 64 octets), so that
+  an edit to the sequence changes only the chunks around it. This suits
+  deduplicating large blobs. Each chunk has a fingerprint, which is its value
+  from ::hash().
+
+  The gear hash (as in FastCDC) is used rather than RollingHash because it
+  needs no window: each octet is shifted and added in, and old octets are
+  shifted out of the top, so there is no octet to drop (and reload) per step
+  and octets more than 64 before the first possible boundary can simply be
+  skipped. It shares RollingHash's octet values.
+
+  Chunks are at least {@c minSize} and at most {@c maxSize} octets (except
+  for the last), and average about {@c averageSize} octets (boundaries being
+  harder to find before that size and easier after it).
+*/
+class Chunker {
   /**
-    Returns a reference to the wrapped object.
+    A chunk found: its size and fingerprint.
   */
-  pub const _T &get () const noexcept;
+  pub struct Chunk {
+    size_t size;
+    size_t h;
+  };
+
+  prv size_t minSize;
+  prv size_t maxSize;
+  prv size_t averageSize;
+  prv iu64f smallMask;
+  prv iu64f largeMask;
+  prv iu64f h;
+  prv size_t size;
+  prv Hasher hasher;
+
   /**
-    Returns an object moved to from the wrapped object.
+    @param averageSize (a power of 2, no less than {@p minSize} and no more
+    than {@p maxSize})
   */
-  pub _T release () && noexcept;
+  pub Chunker (size_t minSize, size_t averageSize, size_t maxSize) noexcept;
 
   /**
-    Returns the hash value of the wrapped object.
+    Consumes octets from the given stream up to the end of the current chunk
+    (leaving {@p r_ptr} just after it) or up to the end of the stream.
+
+    @return whether the end of the current chunk was found (in which case it
+    can be taken with takeChunk()).
   */
-  pub size_t hashFast () const noexcept;
+  pub template<core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator> bool update (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd) noexcept(noexcept(*(r_ptr++)) && noexcept(r_ptr != ptrEnd));
   /**
-    Compares two instances for equality by their wrapped objects.
+    Returns the current chunk (which should be called after update() finds its
+    end, and at the end of the sequence for the last chunk if ::getSize() is
+    not 0) and starts the next.
   */
-  pub bool operator== (const FastHashWrapper<_T> &r) const noexcept(noexcept(r.get() == r.get()));
+  pub Chunk takeChunk () noexcept;
+  /**
+    Returns the number of octets in the current chunk so far.
+  */
+  pub size_t getSize () const noexcept;
+
+  /**
+    Consumes octets from [{@p r_i}, {@p end}) up to the end of the current
+    chunk, returning whether it was found.
+  */
+  prv bool scan (const iu8f *&r_i, const iu8f *end) noexcept;
 };
 
 /**
-  Instances hold an object and expose a hash value for it (from either
-  {@c size_t hashSlow (const _T &)} or
-  {@c size_t hashFast (const _T &) noexcept}).
+  Combines the hash value {@p h} of the next of a sequence of values into
+  {@p seed} (the hash value of the values before it, which is 0 for none),
+  giving a well-distributed hash value that depends on the order of the values.
+  For a given {@p seed}, distinct values of {@p h} give distinct results.
 */
-template<typename _T> class HashWrapper;
+constexpr size_t combineHashes (size_t seed, size_t h) noexcept;
 
-template<typename _T> requires requires (const _T &o) {
-  {hashSlow(o)} -> std::same_as<size_t>;
-} class HashWrapper<_T> : public SlowHashWrapper<_T> {
-  pub using SlowHashWrapper<_T>::SlowHashWrapper;
-};
+/**
+  Hashes values as the elements of composite keys, via
+  {@c static size_t hash (const _T &)} and (if the element can be hashed under
+  a key) {@c static size_t hash (const _T &, const HashKey &)}. It is
+  specialised (after the hashing concepts) for FastHashable types (so the hash
+  values that HashWrappers cache are reused rather than recomputed), for
+  SlowHashable types, for integers and enumerations, and for pairs, tuples and
+  ranges of such elements.
+*/
+template<typename _T> struct ElementHasher;
 
-template<typename _T> requires requires (const _T &o) {
-  {hashFast(o)} noexcept -> std::same_as<size_t>;
-} class HashWrapper<_T> : public FastHashWrapper<_T> {
-  pub using FastHashWrapper<_T>::FastHashWrapper;
+template<typename _T> concept ElementHashable = requires (const _T &o) {
+  {ElementHasher<std::remove_cvref_t<_T>>::hash(o)} -> std::same_as<size_t>;
+};
+template<typename _T> concept KeyedElementHashable = requires (const _T &o, const HashKey &key) {
+  {ElementHasher<std::remove_cvref_t<_T>>::hash(o, key)} -> std::same_as<size_t>;
+};
+/**
+  Ranges that are hashed via their elements (those that do not have hashing
+  member functions of their own, which take precedence).
+*/
+template<typename _R> concept HashableRange = std::ranges::forward_range<_R> && !std::same_as<std::ranges::range_value_t<_R>, _R> && !requires (const _R &o) {
+  o.hashFast();
+} && !requires (const _R &o) {
+  o.hashSlow();
+} && !requires (const _R &o, Hasher &r_hasher) {
+  o.hashSlow(r_hasher);
 };
+/**
+  Types that are hashed via their elements: pairs, tuples and HashableRanges.
+*/
+template<typename _T> inline constexpr bool isHashedViaElements = HashableRange<_T>;
+template<typename _T0, typename _T1> inline constexpr bool isHashedViaElements<std::pair<_T0, _T1>> = true;
+template<typename ..._Ts> inline constexpr bool isHashedViaElements<std::tuple<_Ts...>> = true;
 
 /**
-  Creates a HashWrapper wrapping {@p o}.
+  Implementations of {@c size_t hashSlow (const _T &)}) and
+  {@c size_t hashSlow (const _T &, const HashKey &)}) for pairs, tuples and
+  ranges (e.g. {@c std::array} or {@c std::vector}) of elements that are
+  ElementHashable, which combine the hash values of the elements in order
+  (except that contiguous ranges of integers are hashed as their octets, so
+  that e.g. a {@c std::u8string} hashes as a ::u8string does). An aggregate can
+  be hashed by hashing {@c std::tie()} of its members.
 */
-template<typename _T> HashWrapper<typename std::remove_reference<_T>::type> hashed (_T &&o) noexcept_auto_return(
-  HashWrapper<typename std::remove_reference<_T>::type>(std::forward<_T>(o))
+template<ElementHashable _T0, ElementHashable _T1> size_t hashSlow (const std::pair<_T0, _T1> &o) noexcept_auto_return(
+  ElementHasher<std::pair<_T0, _T1>>::hash(o)
+)
+template<KeyedElementHashable _T0, KeyedElementHashable _T1> size_t hashSlow (const std::pair<_T0, _T1> &o, const HashKey &key) noexcept_auto_return(
+  ElementHasher<std::pair<_T0, _T1>>::hash(o, key)
+)
+template<ElementHashable ..._Ts> size_t hashSlow (const std::tuple<_Ts...> &o) noexcept_auto_return(
+  ElementHasher<std::tuple<_Ts...>>::hash(o)
+)
+template<KeyedElementHashable ..._Ts> size_t hashSlow (const std::tuple<_Ts...> &o, const HashKey &key) noexcept_auto_return(
+  ElementHasher<std::tuple<_Ts...>>::hash(o, key)
+)
+template<HashableRange _R> requires ElementHashable<std::ranges::range_value_t<_R>> size_t hashSlow (const _R &o) noexcept_auto_return(
+  ElementHasher<_R>::hash(o)
+)
+template<HashableRange _R> requires KeyedElementHashable<std::ranges::range_value_t<_R>> size_t hashSlow (const _R &o, const HashKey &key) noexcept_auto_return(
+  ElementHasher<_R>::hash(o, key)
 )
 
-}
-
-namespace std {
-
-template<typename _T> struct hash<const _T> {
-  typedef const _T argument_type;
-  typedef size_t result_type;
-
-  size_t operator() (const _T &o) const noexcept {
-    return std::hash<_T>()(o);
-  }
-};
-
-template<typename _T> struct hash<core::HashWrapper<_T>> {
-  typedef core::HashWrapper<_T> argument_type;
-  typedef size_t result_type;
+/**
+  Implementation of {@c size_t hashSlow (const _T &)}) that leans on a
+  corresponding member function.
+*/
+template<typename _T> requires requires (const _T &o) {
+  {o.hashSlow()} -> std::same_as<size_t>;
+} size_t hashSlow (const _T &o) noexcept_auto_return(
+  o.hashSlow()
+)
+/**
+  Implementation of {@c size_t hashSlow (const _T &)}) that leans on a
+  corresponding member function that feeds the object's contents to a Hasher.
+*/
+template<typename _T> requires requires (const _T &o, Hasher &r_hasher) {
+  o.hashSlow(r_hasher);
+} && (!requires (const _T &o) {
+  o.hashSlow();
+}) size_t hashSlow (const _T &o) noexcept(noexcept(o.hashSlow(std::declval<Hasher &>())));
+/**
+  Implementation of {@c size_t hashSlow (const _T &, const HashKey &)}) that
+  leans on a corresponding member function.
+*/
+template<typename _T> requires requires (const _T &o, const HashKey &key) {
+  {o.hashSlow(key)} -> std::same_as<size_t>;
+} size_t hashSlow (const _T &o, const HashKey &key) noexcept_auto_return(
+  o.hashSlow(key)
+)
+/**
+  Implementation of {@c size_t hashSlow (const _T &, const HashKey &)}) that
+  leans on a corresponding member function that feeds the object's contents to
+  a Hasher.
+*/
+template<typename _T> requires requires (const _T &o, Hasher &r_hasher) {
+  o.hashSlow(r_hasher);
+} && (!requires (const _T &o, const HashKey &key) {
+  o.hashSlow(key);
+}) size_t hashSlow (const _T &o, const HashKey &key) noexcept(noexcept(o.hashSlow(std::declval<Hasher &>())));
+/**
+  Implementation of {@c size_t hashFast (const _T &) noexcept}) that leans on a
+  corresponding member function.
+*/
+template<typename _T> requires requires (const _T &o) {
+  {o.hashFast()} noexcept -> std::same_as<size_t>;
+} size_t hashFast (const _T &o) noexcept {
+  return o.hashFast();
+}
+
+/**
+  Exposes a hash value (from {@c size_t hashSlow (const _T &)}) that may be
+  non-trivial to calculate.
+*/
+template<typename _T> concept SlowHashable = requires (const _T &o) {
+  {hashSlow(o)} -> std::same_as<size_t>;
+};
+/**
+  Exposes a hash value (from {@c size_t hashFast (const _T &) noexcept}) that is
+  so trivial to calculate that it does not need to be persistently cached.
+*/
+template<typename _T> concept FastHashable = requires (const _T &o) {
+  {hashFast(o)} noexcept -> std::same_as<size_t>;
+};
+/**
+  Exposes a hash value under a given key (from
+  {@c size_t hashSlow (const _T &, const HashKey &)}).
+*/
+template<typename _T> concept KeyedSlowHashable = requires (const _T &o, const HashKey &key) {
+  {hashSlow(o, key)} -> std::same_as<size_t>;
+};
+
+/**
+  Implementation of {@c size_t hashSlow (const std::reference_wrapper<_T> &)})
+  that leans on the referenced object.
+*/
+template<SlowHashable _T> size_t hashSlow (const std::reference_wrapper<_T> &o) noexcept_auto_return(
+  hashSlow(o.get())
+)
+/**
+  Implementation of {@c size_t hashFast (const std::reference_wrapper<_T> &) noexcept})
+  that leans on the referenced object.
+*/
+template<FastHashable _T> size_t hashFast (const std::reference_wrapper<_T> &o) noexcept {
+  return hashFast(o.get());
+}
+/**
+  Implementation of {@c size_t hashSlow (const std::reference_wrapper<_T> &, const HashKey &)})
+  that leans on the referenced object.
+*/
+template<KeyedSlowHashable _T> size_t hashSlow (const std::reference_wrapper<_T> &o, const HashKey &key) noexcept_auto_return(
+  hashSlow(o.get(), key)
+)
+
+template<FastHashable _T> struct ElementHasher<_T> {
+  static size_t hash (const _T &o) noexcept;
+  static size_t hash (const _T &o, const HashKey &key) noexcept;
+};
+
+// (The composite types are excluded before SlowHashable is checked, since it
+// depends on their ElementHashers.)
+template<typename _T> requires (!isHashedViaElements<_T> && !FastHashable<_T> && SlowHashable<_T>) struct ElementHasher<_T> {
+  static size_t hash (const _T &o) noexcept(noexcept(hashSlow(o)));
+  static size_t hash (const _T &o, const HashKey &key) noexcept(noexcept(hashSlow(o, key))) requires KeyedSlowHashable<_T>;
+};
+
+template<typename _T> requires std::integral<_T> || std::is_enum_v<_T> struct ElementHasher<_T> {
+  static size_t hash (_T o) noexcept;
+  static size_t hash (_T o, const HashKey &key) noexcept;
+};
+
+template<typename _T0, typename _T1> struct ElementHasher<std::pair<_T0, _T1>> {
+  static size_t hash (const std::pair<_T0, _T1> &o) noexcept(noexcept(
+    ElementHasher<std::tuple<const _T0 &, const _T1 &>>::hash(std::tie(o.first, o.second))
+  )) requires ElementHashable<_T0> && ElementHashable<_T1>;
+  static size_t hash (const std::pair<_T0, _T1> &o, const HashKey &key) noexcept(noexcept(
+    ElementHasher<std::tuple<const _T0 &, const _T1 &>>::hash(std::tie(o.first, o.second), key)
+  )) requires KeyedElementHashable<_T0> && KeyedElementHashable<_T1>;
+};
+
+template<typename ..._Ts> struct ElementHasher<std::tuple<_Ts...>> {
+  static size_t hash (const std::tuple<_Ts...> &o) noexcept((
+    noexcept(ElementHasher<std::remove_cvref_t<_Ts>>::hash(std::declval<const _Ts &>())) && ...
+  )) requires (ElementHashable<_Ts> && ...);
+  static size_t hash (const std::tuple<_Ts...> &o, const HashKey &key) noexcept((
+    noexcept(ElementHasher<std::remove_cvref_t<_Ts>>::hash(std::declval<const _Ts &>(), key)) && ...
+  )) requires (KeyedElementHashable<_Ts> && ...);
+};
+
+template<HashableRange _R> struct ElementHasher<_R> {
+  typedef std::ranges::range_value_t<_R> Element;
+
+  static size_t hash (const _R &o) noexcept(noexcept(
+    ElementHasher<Element>::hash(std::declval<const Element &>())
+  )) requires ElementHashable<Element>;
+  static size_t hash (const _R &o, const HashKey &key) noexcept(noexcept(
+    ElementHasher<Element>::hash(std::declval<const Element &>(), key)
+  )) requires KeyedElementHashable<Element>;
+};
+
+/**
+  Returns the hash value that a SlowHashWrapper stores for {@p o}: either
+  unkeyed or under the process's key.
+*/
+template<bool _keyed, typename _T> requires (!_keyed) size_t wrapperHashSlow (const _T &o) noexcept_auto_return(
+  hashSlow(o)
+)
+template<bool _keyed, typename _T> requires (_keyed) size_t wrapperHashSlow (const _T &o) noexcept_auto_return(
+  hashSlow(o, getProcessHashKey())
+)
+
+/**
+  A hash value that has already been computed for an object, to be given to a
+  HashWrapper (instead of having it hash the object itself).
+*/
+struct PrecomputedHash {
+  size_t h;
+};
+
+template<typename _T, bool _keyed = false> class SlowHashWrapper {
+  prv _T o;
+  prv size_t h;
+
+  /**
+    Constructs the wrapped object in-place (by calling the constructor for
+    {@c _T} with the given arguments forwarded) and stores its hash.
+  */
+  pub template<typename ..._Ts> requires requires (_Ts &&...ts) {
+    {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+  } explicit SlowHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)) && noexcept(wrapperHashSlow<_keyed>(o)));
+  /**
+    Constructs the wrapped object in-place (by calling the constructor for
+    {@c _T} with the given arguments forwarded) and stores the given hash (which
+    must be the one that the object would otherwise be given).
+  */
+  pub template<typename ..._Ts> requires requires (_Ts &&...ts) {
+    {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+  } explicit SlowHashWrapper (PrecomputedHash precomputedH, _Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)));
+
+  /**
+    Returns a reference to the wrapped object.
+  */
+  pub const _T &get () const noexcept;
+  /**
+    Returns an object moved to from the wrapped object.
+  */
+  pub _T release () && noexcept;
+
+  /**
+    Returns the stored hash value of the wrapped object.
+  */
+  pub size_t hashFast () const noexcept;
+  /**
+    Compares two instances for equality by their wrapped objects.
+  */
+  pub bool operator== (const SlowHashWrapper<_T, _keyed> &r) const noexcept(noexcept(r.get() == r.get()));
+};
+
+template<typename _T, bool _keyed = false> class FastHashWrapper {
+  prv _T o;
+
+  /**
+    Constructs the wrapped object in-place (by calling the constructor for
+    {@c _T} with the given arguments forwarded).
+  */
+  pub template<typename ..._Ts> requires requires (_Ts &&...ts) {
+    {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+  } explicit FastHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)));
+
+  /**
+    Returns a reference to the wrapped object.
+  */
+  pub const _T &get () const noexcept;
+  /**
+    Returns an object moved to from the wrapped object.
+  */
+  pub _T release () && noexcept;
+
+  /**
+    Returns the hash value of the wrapped object.
+  */
+  pub size_t hashFast () const noexcept;
+  /**
+    Compares two instances for equality by their wrapped objects.
+  */
+  pub bool operator== (const FastHashWrapper<_T, _keyed> &r) const noexcept(noexcept(r.get() == r.get()));
+};
+
+/**
+  Instances hold an object and expose a hash value for it (from either
+  {@c size_t hashSlow (const _T &)} or
+  {@c size_t hashFast (const _T &) noexcept}). If {@p _keyed}, the hash value is
+  instead taken under the process's key (see ::getProcessHashKey()), from
+  {@c size_t hashSlow (const _T &, const HashKey &)} or by mixing the result of
+  {@c size_t hashFast (const _T &) noexcept}; this stops anyone choosing
+  objects that collide (e.g. to flood a hash table).
+*/
+template<typename _T, bool _keyed = false> class HashWrapper;
+
+template<typename _T, bool _keyed> requires requires (const _T &o) {
+  {hashSlow(o)} -> std::same_as<size_t>;
+} class HashWrapper<_T, _keyed> : public SlowHashWrapper<_T, _keyed> {
+  pub using SlowHashWrapper<_T, _keyed>::SlowHashWrapper;
+};
+
+template<typename _T, bool _keyed> requires requires (const _T &o) {
+  {hashFast(o)} noexcept -> std::same_as<size_t>;
+} class HashWrapper<_T, _keyed> : public FastHashWrapper<_T, _keyed> {
+  pub using FastHashWrapper<_T, _keyed>::FastHashWrapper;
+};
+
+template<typename _c> class string;
+
+/**
+  Writes HashWrappers wrapping strings moved from [{@p i}, {@p end}) to the
+  given output iterator, hashing the strings in batches (see ::hashBatch()).
+  The strings in [{@p i}, {@p end}) are left moved-from.
+*/
+template<
+  bool _keyed = false, std::forward_iterator _InputIterator, typename _InputEndIterator, typename _OutputIterator
+> requires std::same_as<std::iter_value_t<_InputIterator>, string<typename std::iter_value_t<_InputIterator>::value_type>>
+void hashedBatch (_InputIterator i, const _InputEndIterator &end, _OutputIterator &r_ptr);
+
+/**
+  Creates a HashWrapper wrapping {@p o}.
+*/
+template<bool _keyed = false, typename _T> HashWrapper<typename std::remove_reference<_T>::type, _keyed> hashed (_T &&o) noexcept_auto_return(
+  HashWrapper<typename std::remove_reference<_T>::type, _keyed>(std::forward<_T>(o))
+)
+
+/**
+  A SlowHashWrapper that stores only 32 bits of the hash value (folded from
+  all 64), which {@c hashFast()} widens deterministically. The fragment
+  follows the wrapped object as a potentially-overlapping member, so where the
+  ABI reuses tail padding (e.g. for a non-POD {@c _T} under the Itanium ABI)
+  it costs no space at all; otherwise it costs 4 octets rather than 8. This
+  suits large tables of small keys, at the price of 2^-32 rather than 2^-64
+  of unequal keys hashing alike. The widened values differ from those of
+  HashWrapper, so the two must not be mixed in one container.
+*/
+template<SlowHashable _T, bool _keyed = false> class CompactHashWrapper {
+  prv [[no_unique_address]] _T o;
+  prv iu32f h;
+
+  /**
+    Constructs the wrapped object in-place (by calling the constructor for
+    {@c _T} with the given arguments forwarded) and stores its hash.
+  */
+  pub template<typename ..._Ts> requires requires (_Ts &&...ts) {
+    {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+  } explicit CompactHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)) && noexcept(wrapperHashSlow<_keyed>(o)));
+  /**
+    Constructs the wrapped object in-place (by calling the constructor for
+    {@c _T} with the given arguments forwarded) and stores the given (full)
+    hash (which must be the one that the object would otherwise be given).
+  */
+  pub template<typename ..._Ts> requires requires (_Ts &&...ts) {
+    {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+  } explicit CompactHashWrapper (PrecomputedHash precomputedH, _Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)));
+
+  /**
+    Returns a reference to the wrapped object.
+  */
+  pub const _T &get () const noexcept;
+  /**
+    Returns an object moved to from the wrapped object.
+  */
+  pub _T release () && noexcept;
+
+  /**
+    Returns the stored hash fragment, widened to a well-distributed hash value.
+  */
+  pub size_t hashFast () const noexcept;
+  /**
+    Compares two instances for equality by their wrapped objects.
+  */
+  pub bool operator== (const CompactHashWrapper<_T, _keyed> &r) const noexcept(noexcept(r.get() == r.get()));
+
+  prv static iu32f fold (size_t h) noexcept;
+};
+
+/**
+  Creates a CompactHashWrapper wrapping {@p o}.
+*/
+template<bool _keyed = false, typename _T> CompactHashWrapper<typename std::remove_reference<_T>::type, _keyed> compactHashed (_T &&o) noexcept_auto_return(
+  CompactHashWrapper<typename std::remove_reference<_T>::type, _keyed>(std::forward<_T>(o))
+)
+
+/**
+  A string literal together with its hash value (that of the corresponding
+  string), which is computed at compile time. It converts to an (unkeyed)
+  HashWrapper wrapping the corresponding string without hashing it again, so
+  that looking up a fixed key costs nothing for hashing.
+*/
+template<hashing::Octet _c> class HashedLiteral {
+  pub typedef HashWrapper<string<_c>> ComparableKey;
+
+  prv const _c *first;
+  prv const _c *last;
+  prv size_t h;
+
+  /**
+    @param literal (which must end with its only null character, else this
+    fails to compile)
+  */
+  pub template<size_t _n> consteval explicit HashedLiteral (const _c (&literal)[_n]) noexcept;
+
+  /**
+    Returns a pointer to the first character (excluding the null character).
+  */
+  pub constexpr const _c *begin () const noexcept;
+  /**
+    Returns a pointer past the last character (excluding the null character).
+  */
+  pub constexpr const _c *end () const noexcept;
+
+  /**
+    Returns the hash value of the string.
+  */
+  pub constexpr size_t hashFast () const noexcept;
+
+  /**
+    Constructs a HashWrapper wrapping the corresponding string, with the hash
+    value already known.
+  */
+  pub operator HashWrapper<string<_c>> () const;
+};
+
+/**
+  Creates a HashedLiteral for the string literal {@p literal} (at compile time).
+*/
+template<hashing::Octet _c, size_t _n> consteval HashedLiteral<_c> hashedLiteral (const _c (&literal)[_n]) noexcept {
+  return HashedLiteral<_c>(literal);
+}
+
+/**
+  Compares a HashedLiteral with a HashWrapper wrapping a string, by hash value
+  and then by characters.
+*/
+template<hashing::Octet _c> bool operator== (const HashedLiteral<_c> &l, const HashWrapper<string<_c>> &r) noexcept;
+
+/**
+  A borrowed range of characters together with its hash value (that of the
+  corresponding string, unkeyed or under the process's key). It hashes
+  identically to, and compares equal to, a HashWrapper wrapping the
+  corresponding string, so it can be used to look up such keys (in a
+  flathash::Table, or in a standard container using the transparent
+  std::hash<HashWrapper> and std::equal_to<>) without allocating a string.
+  The characters must outlive the view.
+*/
+template<hashing::Octet _c, bool _keyed = false> class HashedView {
+  pub typedef HashWrapper<string<_c>, _keyed> ComparableKey;
+
+  prv const _c *first;
+  prv const _c *last;
+  prv size_t h;
+
+  /**
+    Hashes the characters [{@p i}, {@p end}).
+  */
+  pub HashedView (const _c *i, const _c *end) noexcept;
+  /**
+    Hashes the characters of the null-terminated string {@p s} (excluding the
+    null character).
+  */
+  pub explicit HashedView (const _c *s) noexcept;
+  /**
+    Hashes the characters of {@p s}, which must not be modified while the view
+    is in use.
+  */
+  pub explicit HashedView (const string<_c> &s) noexcept;
+  /**
+    Takes the characters and hash value of {@p l}.
+  */
+  pub constexpr HashedView (const HashedLiteral<_c> &l) noexcept requires (!_keyed);
+
+  /**
+    Returns a pointer to the first character.
+  */
+  pub const _c *begin () const noexcept;
+  /**
+    Returns a pointer past the last character.
+  */
+  pub const _c *end () const noexcept;
+  /**
+    Returns the number of characters.
+  */
+  pub size_t size () const noexcept;
+
+  /**
+    Returns the hash value of the characters.
+  */
+  pub size_t hashFast () const noexcept;
+};
+
+/**
+  Compares a HashedView with a HashWrapper wrapping a string, by hash value and
+  then by characters.
+*/
+template<hashing::Octet _c, bool _keyed> bool operator== (const HashedView<_c, _keyed> &l, const HashWrapper<string<_c>, _keyed> &r) noexcept;
+
+/**
+  Creates a HashedView of the characters [{@p i}, {@p end}).
+*/
+template<bool _keyed = false, hashing::Octet _c> HashedView<_c, _keyed> hashedView (const _c *i, const _c *end) noexcept {
+  return HashedView<_c, _keyed>(i, end);
+}
+/**
+  Creates a HashedView of the null-terminated string {@p s}.
+*/
+template<bool _keyed = false, hashing::Octet _c> HashedView<_c, _keyed> hashedView (const _c *s) noexcept {
+  return HashedView<_c, _keyed>(s);
+}
+/**
+  Creates a HashedView of the characters of {@p s}.
+*/
+template<bool _keyed = false, hashing::Octet _c> HashedView<_c, _keyed> hashedView (const string<_c> &s) noexcept {
+  return HashedView<_c, _keyed>(s);
+}
+
+}
+
+namespace std {
+
+template<typename _T> struct hash<const _T> {
+  typedef const _T argument_type;
+  typedef size_t result_type;
+
+  size_t operator() (const _T &o) const noexcept {
+    return std::hash<_T>()(o);
+  }
+};
+
+/**
+  Hashes HashWrappers by their stored hash values. This is transparent: with
+  std::equal_to<> as the key equality, a standard unordered container of
+  HashWrappers can be searched with any other type that names the HashWrapper
+  as its {@c ComparableKey} (e.g. a HashedView or a HashedLiteral), without
+  constructing a HashWrapper.
+*/
+template<typename _T, bool _keyed> struct hash<core::HashWrapper<_T, _keyed>> {
+  typedef core::HashWrapper<_T, _keyed> argument_type;
+  typedef size_t result_type;
+  typedef void is_transparent;
+
+  size_t operator() (const core::HashWrapper<_T, _keyed> &o) const noexcept {
+    return o.hashFast();
+  }
+
+  template<typename _Q> requires std::same_as<typename _Q::ComparableKey, core::HashWrapper<_T, _keyed>> size_t operator() (const _Q &o) const noexcept {
+    return o.hashFast();
+  }
+};
+
+template<typename _T, bool _keyed> struct hash<core::CompactHashWrapper<_T, _keyed>> {
+  typedef core::CompactHashWrapper<_T, _keyed> argument_type;
+  typedef size_t result_type;
+
+  size_t operator() (const core::CompactHashWrapper<_T, _keyed> &o) const noexcept {
+    return o.hashFast();
+  }
+};
+
+template<typename _T> struct hash<std::reference_wrapper<_T>> {
+  typedef std::reference_wrapper<_T> argument_type;
+  typedef size_t result_type;
+
+  size_t operator() (const std::reference_wrapper<_T> &o) const noexcept {
+    return std::hash<_T>()(o.get());
+  }
+};
+
+template<typename _T> struct equal_to<std::reference_wrapper<_T>> {
+  typedef std::reference_wrapper<_T> first_argument_type;
+  typedef std::reference_wrapper<_T> second_argument_type;
+  typedef bool result_type;
+
+  bool operator() (const std::reference_wrapper<_T> &l, const std::reference_wrapper<_T> &r) const noexcept(noexcept(l.get() == r.get())) {
+    return std::equal_to<_T>()(l.get(), r.get());
+  }
+};
+
+}
+
+/* -----------------------------------------------------------------------------
+   Hash tables
+----------------------------------------------------------------------------- */
+namespace core::flathash {
+
+/**
+  The control octet of each slot of a table is either one of these or, if the
+  slot is full, 7 bits of the hash value of its element.
+*/
+inline constexpr is8f ctrlEmpty = -128;
+inline constexpr is8f ctrlDeleted = -2;
+inline constexpr is8f ctrlSentinel = -1;
+
+/**
+  The set of the slots in a Group that match some condition.
+*/
+template<typename _i, iu _sh> class GroupMask {
+  prv _i bits;
+
+  pub explicit constexpr GroupMask (_i bits) noexcept;
+
+  /**
+    Returns whether there are any slots in the set.
+  */
+  pub explicit operator bool () const noexcept;
+  /**
+    Returns the index (within the Group) of the first slot in the set.
+  */
+  pub iu lowest () const noexcept;
+  /**
+    Removes the first slot from the set.
+  */
+  pub void removeLowest () noexcept;
+};
+
+/**
+  The control octets of a run of (consecutive) slots, which are examined all at
+  once (by SSE2).
+*/
+#if defined(ARCH_X86) && defined(__SSE2__)
+class Sse2Group {
+  pub static constexpr size_t width = 16;
+  pub typedef GroupMask<iu32f, 0> Mask;
+
+  prv __m128i ctrls;
+
+  pub explicit Sse2Group (const is8f *ctrls) noexcept;
+
+  /**
+    Returns the slots that may be full with an element of the given hash value
+    (as {@c h & 0x7F}).
+  */
+  pub Mask match (is8f h2) const noexcept;
+  pub Mask matchEmpty () const noexcept;
+  pub Mask matchEmptyOrDeleted () const noexcept;
+};
+#endif
+
+/**
+  The control octets of a run of (consecutive) slots, which are examined all at
+  once (as the octets of a word, on any CPU).
+*/
+class WordGroup {
+  pub static constexpr size_t width = 8;
+  pub typedef GroupMask<iu64f, 3> Mask;
+
+  prv iu64f ctrls;
+
+  pub explicit WordGroup (const is8f *ctrls) noexcept;
+
+  pub Mask match (is8f h2) const noexcept;
+  pub Mask matchEmpty () const noexcept;
+  pub Mask matchEmptyOrDeleted () const noexcept;
+};
+
+/**
+  The Group that tables use unless told otherwise: the widest that the target
+  supports.
+*/
+#if defined(ARCH_X86) && defined(__SSE2__)
+typedef Sse2Group Group;
+#else
+typedef WordGroup Group;
+#endif
+
+/**
+  Types other than {@p _K} that can be used to look up elements with keys of
+  type {@p _K}, without constructing a {@c _K}. Such a type opts in by naming
+  {@p _K} as its {@c ComparableKey}, promising that its instances hash
+  identically to the keys that they compare equal to.
+*/
+template<typename _Q, typename _K> concept LookupKey = !std::same_as<_Q, _K> && FastHashable<_Q> && std::same_as<typename _Q::ComparableKey, _K> && requires (const _Q &q, const _K &k) {
+  {q == k} -> std::convertible_to<bool>;
+};
+
+/**
+  Iterates over the full slots of a Table.
+*/
+template<typename _E> class Iterator {
+  prv const is8f *ctrl;
+  prv _E *slot;
+
+  pub typedef std::forward_iterator_tag iterator_category;
+  pub typedef typename std::remove_const<_E>::type value_type;
+  pub typedef ptrdiff_t difference_type;
+  pub typedef _E *pointer;
+  pub typedef _E &reference;
+
+  pub Iterator () noexcept;
+  /**
+    Constructs an iterator at the first full slot from the given one onwards
+    (or the end, if there is none).
+  */
+  pub Iterator (const is8f *ctrl, _E *slot) noexcept;
+  /**
+    Converts from a non-const iterator.
+  */
+  pub template<typename _E2> requires std::same_as<const _E2, _E> Iterator (const Iterator<_E2> &o) noexcept;
+
+  pub _E &operator* () const noexcept;
+  pub _E *operator-> () const noexcept;
+  pub Iterator<_E> &operator++ () noexcept;
+  pub Iterator<_E> operator++ (int) noexcept;
+  pub bool operator== (const Iterator<_E> &r) const noexcept;
+
+  template<typename _E2> friend class Iterator;
+  template<typename _K, typename _E2, bool _mutableElements, typename _G> friend class Table;
+};
+
+/**
+  An open-addressing hash table of elements of type {@p _E} that are looked up
+  by keys of type {@p _K} (which must be FastHashable), and which can be
+  modified in place only if {@p _mutableElements}. Each slot has a control
+  octet, and the control octets for a Group of slots are probed at once, so
+  that most lookups touch one run of control octets and the one slot holding
+  the element. Keys are never rehashed other than by
+  {@c size_t hashFast (const _K &) noexcept}, which for a HashWrapper just
+  returns the stored hash value. The control octets are examined by {@p _G}
+  (one of the Group types).
+*/
+template<typename _K, typename _E, bool _mutableElements, typename _G = Group> class Table {
+  prv is8f *ctrls;
+  prv _E *slots;
+  prv size_t capacity;
+  prv size_t elementCount;
+  prv size_t growthLeft;
+
+  pub typedef _K key_type;
+  pub typedef _E value_type;
+  pub typedef size_t size_type;
+  pub typedef Iterator<typename std::conditional<_mutableElements, _E, const _E>::type> iterator;
+  pub typedef Iterator<const _E> const_iterator;
+
+  pub Table () noexcept;
+  pub Table (const Table<_K, _E, _mutableElements, _G> &o);
+  pub Table (Table<_K, _E, _mutableElements, _G> &&o) noexcept;
+  pub Table<_K, _E, _mutableElements, _G> &operator= (const Table<_K, _E, _mutableElements, _G> &o);
+  pub Table<_K, _E, _mutableElements, _G> &operator= (Table<_K, _E, _mutableElements, _G> &&o) noexcept;
+  pub ~Table () noexcept;
+
+  pub size_t size () const noexcept;
+  pub bool empty () const noexcept;
+  /**
+    Destroys all of the elements (keeping the storage for them).
+  */
+  pub void clear () noexcept;
+  /**
+    Makes room for at least {@p count} elements in total without further
+    allocation.
+  */
+  pub void reserve (size_t count);
+
+  pub iterator begin () noexcept;
+  pub const_iterator begin () const noexcept;
+  pub iterator end () noexcept;
+  pub const_iterator end () const noexcept;
+
+  /**
+    Returns an iterator at the element with the given key, or the end if there
+    is none.
+  */
+  pub iterator find (const _K &key) noexcept(noexcept(key == key));
+  pub const_iterator find (const _K &key) const noexcept(noexcept(key == key));
+  /**
+    Returns an iterator at the element with a key equal to {@p key} (which is of
+    some other type that hashes identically to equal keys, such as a
+    HashedView), or the end if there is none.
+  */
+  pub template<typename _Q> requires LookupKey<_Q, _K> iterator find (const _Q &key) noexcept(noexcept(key == std::declval<const _K &>()));
+  pub template<typename _Q> requires LookupKey<_Q, _K> const_iterator find (const _Q &key) const noexcept(noexcept(key == std::declval<const _K &>()));
+  pub bool contains (const _K &key) const noexcept(noexcept(key == key));
+  pub template<typename _Q> requires LookupKey<_Q, _K> bool contains (const _Q &key) const noexcept(noexcept(key == std::declval<const _K &>()));
+
+  /**
+    Destroys the element with the given key, if there is one.
+
+    @return the number of elements destroyed.
+  */
+  pub size_t erase (const _K &key) noexcept(noexcept(key == key));
+  pub template<typename _Q> requires LookupKey<_Q, _K> size_t erase (const _Q &key) noexcept(noexcept(key == std::declval<const _K &>()));
+  /**
+    Destroys the element at the given iterator.
+
+    @return an iterator at the next element.
+  */
+  pub iterator erase (const_iterator i) noexcept;
+
+  prv static const _K &getKey (const _E &e) noexcept;
+  prv static size_t getCtrlsSize (size_t capacity) noexcept;
+  prv static size_t getGrowth (size_t capacity) noexcept;
+  prv static iu64f mixHash (size_t h) noexcept;
+  prv template<typename _Q> size_t findIndex (const _Q &key, iu64f m) const noexcept(noexcept(key == std::declval<const _K &>()));
+  prv size_t findNonFullIndex (iu64f m) const noexcept;
+  prv void setCtrl (size_t index, is8f ctrl) noexcept;
+  prv void rehash (size_t newCapacity);
+  prv void destroy () noexcept;
+  /**
+    Finds the slot for the element with the given key (constructing it, by
+    calling {@p construct} with a pointer to the slot, if there isn't one).
+
+    @return the index of the slot and whether an element was constructed.
+  */
+  prt template<typename _F> std::pair<size_t, bool> findOrInsert (const _K &key, _F &&construct);
+  prt iterator at (size_t index) noexcept;
+};
+
+}
+
+namespace core {
+
+/**
+  A set of FastHashable elements (such as HashWrapper instances) held in a
+  flat, open-addressing hash table (see flathash::Table), which takes much
+  less memory and fewer cache misses per lookup than {@c std::unordered_set}.
+  Inserting or erasing invalidates iterators and references to elements.
+*/
+template<typename _K, typename _G = flathash::Group> requires FastHashable<_K> class FlatHashSet : public flathash::Table<_K, _K, false, _G> {
+  pub typedef typename flathash::Table<_K, _K, false, _G>::iterator iterator;
+
+  pub using flathash::Table<_K, _K, false, _G>::Table;
+
+  /**
+    Inserts a copy of (or, for an rvalue, the object moved from) {@p o} if there
+    is no equal element.
+
+    @return an iterator at the element equal to {@p o} and whether it was
+    inserted.
+  */
+  pub std::pair<iterator, bool> insert (const _K &o);
+  pub std::pair<iterator, bool> insert (_K &&o);
+  /**
+    Constructs an element from the given arguments and inserts it if there is no
+    equal element.
+  */
+  pub template<typename ..._Ts> std::pair<iterator, bool> emplace (_Ts &&...ts);
+};
+
+/**
+  An entry of a FlatHashMap.
+*/
+template<typename _K, typename _V> class FlatHashMapEntry {
+  prv _K key;
+  prv _V value;
+
+  pub template<typename _KArg, typename ..._Ts> FlatHashMapEntry (_KArg &&key, _Ts &&...ts);
+
+  pub const _K &getKey () const noexcept;
+  pub _V &getValue () noexcept;
+  pub const _V &getValue () const noexcept;
+};
+
+/**
+  A map from FastHashable keys (such as HashWrapper instances) held in a flat,
+  open-addressing hash table (see flathash::Table). Inserting or erasing
+  invalidates iterators and references to entries.
+*/
+template<typename _K, typename _V, typename _G = flathash::Group> requires FastHashable<_K> class FlatHashMap : public flathash::Table<_K, FlatHashMapEntry<_K, _V>, true, _G> {
+  pub typedef typename flathash::Table<_K, FlatHashMapEntry<_K, _V>, true, _G>::iterator iterator;
+  pub typedef _V mapped_type;
+
+  pub using flathash::Table<_K, FlatHashMapEntry<_K, _V>, true, _G>::Table;
+
+  /**
+    Inserts an entry with a copy of (or, for an rvalue, the object moved from)
+    {@p key} and a value constructed from the given arguments, if there is no
+    entry with an equal key.
+
+    @return an iterator at the entry with a key equal to {@p key} and whether it
+    was inserted.
+  */
+  pub template<typename ..._Ts> std::pair<iterator, bool> try_emplace (const _K &key, _Ts &&...ts);
+  pub template<typename ..._Ts> std::pair<iterator, bool> try_emplace (_K &&key, _Ts &&...ts);
+  /**
+    Returns the value for the given key (inserting an entry with a
+    value-initialised value if there isn't one).
+  */
+  pub _V &operator[] (const _K &key);
+  pub _V &operator[] (_K &&key);
+};
+
+/**
+  A map from FastHashable keys (such as HashWrapper instances) that can be used
+  by many threads at once. Entries are spread over shards by their keys' hash
+  values; each shard is a FlatHashMap with its own reader-writer lock, so reads
+  only contend with writes to the same shard (and never with each other for
+  exclusive access), and writes to different shards proceed in parallel.
+
+  References to values are never handed out (since another thread could erase
+  or move the entry); instead, values are copied out or visited under the
+  shard's lock.
+*/
+template<typename _K, typename _V> requires FastHashable<_K> class ConcurrentHashMap {
+  prv class alignas(64) Shard {
+    pub mutable std::shared_mutex mutex;
+    pub FlatHashMap<_K, _V> map;
+  };
+
+  prv std::unique_ptr<Shard[]> shards;
+  prv size_t shardMask;
+
+  /**
+    @param shardCount the number of shards (which is rounded up to a power of
+    two), which should be several times the number of threads that will use
+    the map at once.
+  */
+  pub explicit ConcurrentHashMap (size_t shardCount = 64);
+  ConcurrentHashMap (const ConcurrentHashMap &) = delete;
+  ConcurrentHashMap &operator= (const ConcurrentHashMap &) = delete;
+
+  /**
+    Returns the number of entries (which, if other threads are modifying the
+    map, may never have been the number at any one time).
+  */
+  pub size_t size () const;
+  pub void clear ();
+
+  pub bool contains (const _K &key) const;
+  /**
+    Returns whether there is an entry for the given key (which is of some other
+    type, as for flathash::Table::find()).
+  */
+  pub template<typename _Q> requires flathash::LookupKey<_Q, _K> bool contains (const _Q &key) const;
+  /**
+    Returns a copy of the value for the given key, if there is an entry for it.
+  */
+  pub std::optional<_V> get (const _K &key) const;
+  pub template<typename _Q> requires flathash::LookupKey<_Q, _K> std::optional<_V> get (const _Q &key) const;
+  /**
+    Calls {@p visitor} with a const reference to the value for the given key (if
+    there is an entry for it), holding the shard's lock for reading.
+
+    @return whether there was an entry.
+  */
+  pub template<typename _F> bool visit (const _K &key, _F &&visitor) const;
+  pub template<typename _Q, typename _F> requires flathash::LookupKey<_Q, _K> bool visit (const _Q &key, _F &&visitor) const;
+  /**
+    Calls {@p visitor} with a const reference to each key and value, holding
+    each shard's lock for reading in turn.
+  */
+  pub template<typename _F> void forEach (_F &&visitor) const;
+
+  /**
+    Inserts an entry with the given key and a value constructed from the given
+    arguments, if there is no entry with an equal key.
+
+    @return whether the entry was inserted.
+  */
+  pub template<typename ..._Ts> bool try_emplace (const _K &key, _Ts &&...ts);
+  /**
+    Sets the value for the given key (inserting an entry, if there isn't one).
+
+    @return whether the entry was inserted.
+  */
+  pub template<typename _VArg> bool insert_or_assign (const _K &key, _VArg &&value);
+  /**
+    Calls {@p updater} with a reference to the value for the given key (first
+    inserting an entry with a value-initialised value, if there isn't one),
+    holding the shard's lock for writing. This is how to modify a value
+    atomically (e.g. to increment a count).
+  */
+  pub template<typename _F> void update (const _K &key, _F &&updater);
+  /**
+    Erases the entry with the given key, if there is one.
+
+    @return whether there was an entry.
+  */
+  pub bool erase (const _K &key);
+
+  prv template<typename _Q> Shard &getShard (const _Q &key) const noexcept;
+  prv template<typename _Q> bool containsImpl (const _Q &key) const;
+  prv template<typename _Q> std::optional<_V> getImpl (const _Q &key) const;
+  prv template<typename _Q, typename _F> bool visitImpl (const _Q &key, _F &&visitor) const;
+};
+
+}
+
+/* -----------------------------------------------------------------------------
+   Bloom filters
+----------------------------------------------------------------------------- */
+namespace core {
+
+/**
+  A blocked Bloom filter: a compact summary of a set of keys, which answers
+  either that a key may be in the set (being wrong at a false positive rate
+  that is chosen up front) or that it is definitely not. It suits guarding
+  lookups that mostly miss.
+
+  Each key sets 8 bits in one 32-octet block (one in each 32-bit word of the
+  block, at positions picked by double hashing), so inserting or testing a key
+  touches a single cache line and the words are tested together with SIMD
+  where available. Keys are hashed with
+  {@c size_t hashFast (const _K &) noexcept}, so a HashWrapper's stored hash
+  value is reused rather than the key being hashed again.
+
+  Filters can be written out and read back (e.g. to ship prebuilt ones) with a
+  header in the {@c ieu} format, as long as the keys hash alike in the reading
+  process (i.e. the keys are unkeyed HashWrappers).
+*/
+class BloomFilter {
+  prv static constexpr iu formatVersion = 1;
+  prv static constexpr size_t readingBlockCount = 4096;
+
+  prv struct alignas(32) Block {
+    iu32f words[8];
+  };
+
+  // (No more than 2^32 blocks, since the block is picked with 32 bits of the
+  // hash value, and no more than can be allocated.)
+  prv static constexpr iu64f maxBlockCount = std::numeric_limits<size_t>::max() / sizeof(Block) < static_cast<iu64f>(1) << 32 ? std::numeric_limits<size_t>::max() / sizeof(Block) : static_cast<iu64f>(1) << 32;
+
+  prv std::unique_ptr<Block[]> blocks;
+  prv size_t blockCount;
+
+  /**
+    Constructs an empty filter sized to give a false positive rate of about
+    {@p falsePositiveRate} (which must be greater than 0 and less than 1) once
+    {@p expectedCount} keys have been inserted.
+  */
+  pub BloomFilter (size_t expectedCount, double falsePositiveRate);
+  prv explicit BloomFilter (size_t blockCount);
+
+  /**
+    Inserts the given key.
+  */
+  pub template<FastHashable _K> void insert (const _K &key) noexcept;
+  /**
+    Returns false if the given key has definitely not been inserted (or true if
+    it may have been).
+  */
+  pub template<FastHashable _K> bool mayContain (const _K &key) const noexcept;
+  /**
+    Inserts a key with the given hash value (as from
+    {@c size_t hashFast (const _K &) noexcept}).
+  */
+  pub void insertHash (size_t h) noexcept;
+  /**
+    Returns false if no key with the given hash value has been inserted.
+  */
+  pub bool mayContainHash (size_t h) const noexcept;
+
+  /**
+    Removes all keys.
+  */
+  pub void clear () noexcept;
+  /**
+    Inserts all of the keys inserted into {@p o}, which must have been
+    constructed with the same arguments (or read from such a filter).
+  */
+  pub void merge (const BloomFilter &o) noexcept;
+
+  /**
+    Returns the number of octets of bits.
+  */
+  pub size_t getSize () const noexcept;
+  /**
+    Returns the expected false positive rate once {@p count} keys have been
+    inserted.
+  */
+  pub double getFalsePositiveRate (size_t count) const noexcept;
+  /**
+    Returns the number of octets that write() writes.
+  */
+  pub size_t getWrittenSize () const noexcept;
 
-  size_t operator() (const core::HashWrapper<_T> &o) const noexcept {
-    return o.hashFast();
-  }
+  /**
+    Writes the filter to the given octet stream: the format version and the
+    number of blocks (as {@c ieu}s) and then the words of the blocks (as
+    little-endian 32-bit integers).
+  */
+  pub template<core::OutputIterator<iu8f> _OutputIterator> void write (_OutputIterator &r_ptr) const;
+  /**
+    Reads a filter written by write() from the given octet stream.
+
+    @throw PlainException if the stream is truncated or is of an unsupported
+    format (or std::overflow_error if a header value is too big).
+  */
+  pub template<core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator> static BloomFilter read (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd);
+
+  prv static size_t getBlockCount (size_t expectedCount, double falsePositiveRate);
+  prv static double getFalsePositiveRate (double keysPerBlock) noexcept;
 };
 
-template<typename _T> struct hash<std::reference_wrapper<_T>> {
-  typedef std::reference_wrapper<_T> argument_type;
-  typedef size_t result_type;
+}
 
-  size_t operator() (const std::reference_wrapper<_T> &o) const noexcept {
-    return std::hash<_T>()(o.get());
-  }
+/* -----------------------------------------------------------------------------
+   Delta sequences
+----------------------------------------------------------------------------- */
+namespace core {
+
+/**
+  Appends the {@p count} values at {@p in} to the given octet container as a
+  delta sequence, which suits sorted values (e.g. ids and timestamps) but holds
+  any. The sequence is the number of values (as an {@c ieu}) and then blocks of
+  up to DeltaSequenceReader::blockSize values, each being its size in octets
+  and then its first value and the zigzag encodings of the differences between
+  its consecutive values (all as {@c ieu}s, with the first value zigzag-encoded
+  too if {@p _i} is signed). The block sizes let readers skip blocks without
+  decoding them.
+*/
+template<typename _Octets, std::integral _i> requires requires (_Octets &r_octets, size_t size) {
+  r_octets.resize(size);
+  {r_octets.data()} -> std::same_as<iu8f *>;
+} void writeDeltaSequence (_Octets &r_octets, const _i *in, size_t count);
+
+/**
+  A reader of a delta sequence of values of type {@p _i} (as written by
+  writeDeltaSequence()), which decodes a block at a time (with the differences
+  being decoded in bulk and summed by SIMD where available) and can skip blocks
+  without decoding them.
+*/
+template<std::integral _i> class DeltaSequenceReader {
+  /**
+    The maximum number of values in a block.
+  */
+  pub static constexpr size_t blockSize = 128;
+
+  prv const iu8f *ptr;
+  prv const iu8f *ptrEnd;
+  prv size_t count;
+  prv size_t index;
+
+  /**
+    Constructs a reader of the delta sequence at {@p ptr}.
+
+    @throw PlainException if the stream is truncated.
+  */
+  pub DeltaSequenceReader (const iu8f *ptr, const iu8f *ptrEnd);
+
+  /**
+    Returns the number of values in the sequence.
+  */
+  pub size_t size () const noexcept;
+  /**
+    Returns the index of the next value to be read (which is at the start of a
+    block).
+  */
+  pub size_t getIndex () const noexcept;
+  /**
+    Returns the reader's position in the octet stream (which is after the
+    sequence once all of the blocks have been read or skipped).
+  */
+  pub const iu8f *getPtr () const noexcept;
+
+  /**
+    Decodes the next block into {@p out} (which must have room for blockSize
+    values), returning the number of values in it (or 0 if there are no more
+    blocks).
+
+    @throw PlainException if the stream is truncated or the block is malformed
+    (or std::overflow_error if a value is too big).
+  */
+  pub size_t readBlock (_i *out);
+  /**
+    Decodes the remaining blocks into {@p out} (which must have room for
+    size() - getIndex() values).
+
+    @throw as readBlock() does.
+  */
+  pub void readAll (_i *out);
+  /**
+    Skips the next block without decoding it, returning false if there are no
+    more blocks.
+
+    @throw PlainException if the stream is truncated.
+  */
+  pub bool skipBlock ();
+  /**
+    Skips blocks up to the one that holds the value at {@p index} (or to the end
+    if there's no such value).
+
+    @throw as skipBlock() does.
+  */
+  pub void skipToIndex (size_t index);
+  /**
+    For a sequence of values in ascending order, skips each block whose
+    following block starts with a value less than {@p value} (so that the first
+    value that is not less than {@p value}, if there is one, is in the next
+    block read or the one after that), looking only at the blocks' first
+    values.
+
+    @throw PlainException if the stream is truncated (or std::overflow_error if
+    a value is too big).
+  */
+  pub void skipToValue (_i value);
+
+  prv size_t getBlockCount () const noexcept;
+  prv static _i readFirstValue (const iu8f *ptr, const iu8f *ptrEnd);
 };
 
-template<typename _T> struct equal_to<std::reference_wrapper<_T>> {
-  typedef std::reference_wrapper<_T> first_argument_type;
-  typedef std::reference_wrapper<_T> second_argument_type;
-  typedef bool result_type;
+/**
+  The implementations of the summing of DeltaSequenceReader::readBlock(),
+  which turn {@p values} (the first value, then the zigzag encodings of the
+  differences between consecutive values) into the values.
+*/
+void addZigzagDeltas (iu32f *values, size_t count) noexcept;
+void addZigzagDeltas (iu64f *values, size_t count) noexcept;
 
-  bool operator() (const std::reference_wrapper<_T> &l, const std::reference_wrapper<_T> &r) const noexcept(noexcept(l.get() == r.get())) {
-    return std::equal_to<_T>()(l.get(), r.get());
-  }
+}
+
+/* -----------------------------------------------------------------------------
+   Octet streams
+----------------------------------------------------------------------------- */
+namespace core {
+
+/**
+  A buffered source of octets, which presents a window onto the stream
+  ([getPtr(), getEnd())) that is refilled (by the subclass's supply()) as it
+  is consumed, so that the octets can be read through raw pointers.
+  readIeu() and readIes() have overloads that take sources, which read each
+  value from the window (making sure that it has room for the longest value
+  first, rather than checking for the end of the window at each octet).
+*/
+class OctetSource {
+  prv std::unique_ptr<iu8f[]> buffer;
+  prv size_t capacity;
+  prv const iu8f *ptr;
+  prv const iu8f *end;
+  prv bool exhausted;
+
+  /**
+    Constructs a source whose window can hold up to {@p capacity} octets.
+
+    @throw std::invalid_argument if the window couldn't hold the longest value
+    in the variable-length formats.
+  */
+  pub explicit OctetSource (size_t capacity = 65536);
+  OctetSource (const OctetSource &) = delete;
+  OctetSource &operator= (const OctetSource &) = delete;
+  OctetSource (OctetSource &&) = delete;
+  OctetSource &operator= (OctetSource &&) = delete;
+  pub virtual ~OctetSource () noexcept;
+
+  /**
+    Returns the start of the window (i.e. the next octet of the stream).
+  */
+  pub const iu8f *getPtr () const noexcept;
+  /**
+    Returns the end of the window.
+  */
+  pub const iu8f *getEnd () const noexcept;
+  /**
+    Consumes the octets of the window before {@p ptr} (which must be within
+    the window).
+  */
+  pub void setPtr (const iu8f *ptr) noexcept;
+
+  /**
+    Refills the window (moving its octets to the start of the buffer and
+    supplying octets after them), returning false if no octets were added
+    (because the stream has ended or the window is full).
+  */
+  pub bool refill ();
+  /**
+    Refills the window until it holds at least {@p size} octets (which must be
+    no more than the capacity), returning false if the stream ended first.
+  */
+  pub bool require (size_t size);
+  /**
+    Returns true if all of the octets of the stream have been consumed
+    (refilling the window to find out).
+  */
+  pub bool isExhausted ();
+  /**
+    Copies up to {@p size} octets of the stream to {@p out}, returning the
+    number copied (which is less than {@p size} only if the stream has ended).
+  */
+  pub size_t read (iu8f *out, size_t size);
+
+  /**
+    Writes up to {@p size} (which is nonzero) octets of the underlying stream to
+    {@p out}, returning the number written (which is 0 only if the stream has
+    ended).
+  */
+  prv virtual size_t supply (iu8f *out, size_t size) = 0;
+};
+
+/**
+  A buffered sink for octets, which presents a window of space
+  ([getPtr(), getEnd())) that is emptied (by the subclass's consume()) as it
+  fills, so that the octets can be written through raw pointers. writeIeu()
+  and writeIes() have overloads that take sinks, which write each value into
+  the window (making sure that it has room for the longest value first).
+
+  Octets are only written to the underlying stream by flush() (which subclasses
+  must call, if they are to flush on destruction).
+*/
+class OctetSink {
+  prv std::unique_ptr<iu8f[]> buffer;
+  prv size_t capacity;
+  prv iu8f *ptr;
+
+  /**
+    Constructs a sink whose window can hold up to {@p capacity} octets.
+
+    @throw std::invalid_argument if the window couldn't hold the longest value
+    in the variable-length formats.
+  */
+  pub explicit OctetSink (size_t capacity = 65536);
+  OctetSink (const OctetSink &) = delete;
+  OctetSink &operator= (const OctetSink &) = delete;
+  OctetSink (OctetSink &&) = delete;
+  OctetSink &operator= (OctetSink &&) = delete;
+  pub virtual ~OctetSink () noexcept;
+
+  /**
+    Returns the start of the window (i.e. where the next octet goes).
+  */
+  pub iu8f *getPtr () const noexcept;
+  /**
+    Returns the end of the window.
+  */
+  pub iu8f *getEnd () const noexcept;
+  /**
+    Commits the octets before {@p ptr} (which must be within the window).
+  */
+  pub void setPtr (iu8f *ptr) noexcept;
+
+  /**
+    Flushes the committed octets if need be to make the window hold at least
+    {@p size} octets (which must be no more than the capacity).
+  */
+  pub void require (size_t size);
+  /**
+    Writes the committed octets to the underlying stream.
+  */
+  pub void flush ();
+  /**
+    Writes the octets [{@p i}, {@p end}) (passing long runs straight to the
+    underlying stream).
+  */
+  pub void write (const iu8f *i, const iu8f *end);
+
+  /**
+    Writes the {@p size} octets at {@p ptr} to the underlying stream.
+  */
+  prv virtual void consume (const iu8f *ptr, size_t size) = 0;
+};
+
+/**
+  An OctetSource that reads from a stdio file (which it doesn't own).
+*/
+class FileOctetSource : public OctetSource {
+  prv FILE *handle;
+
+  pub explicit FileOctetSource (FILE *handle, size_t capacity = 65536);
+
+  /**
+    @throw PlainException if the file can't be read.
+  */
+  prv virtual size_t supply (iu8f *out, size_t size) override;
+};
+
+/**
+  An OctetSink that writes to a stdio file (which it doesn't own), flushing on
+  destruction (ignoring any failure, which calling flush() first reveals).
+*/
+class FileOctetSink : public OctetSink {
+  prv FILE *handle;
+
+  pub explicit FileOctetSink (FILE *handle, size_t capacity = 65536);
+  pub virtual ~FileOctetSink () noexcept override;
+
+  /**
+    @throw PlainException if the file can't be written.
+  */
+  prv virtual void consume (const iu8f *ptr, size_t size) override;
+};
+
+/**
+  Reads a value of type {@p _i} from the given source in the unsigned
+  variable-length format, as readIeu() does from an octet stream.
+*/
+template<std::unsigned_integral _i> _i readIeu (OctetSource &r_source);
+/**
+  Reads a value of type {@p _i} from the given source in the signed
+  variable-length format, as readIes() does from an octet stream.
+*/
+template<std::signed_integral _i> _i readIes (OctetSource &r_source);
+/**
+  Writes a value of type {@p _i} to the given sink in the unsigned
+  variable-length format.
+*/
+template<std::unsigned_integral _i> void writeIeu (OctetSink &r_sink, _i value);
+/**
+  Writes a value of type {@p _i} to the given sink in the signed
+  variable-length format.
+*/
+template<std::signed_integral _i> void writeIes (OctetSink &r_sink, _i value);
+
+}
+
+/* -----------------------------------------------------------------------------
+   Mapped files
+----------------------------------------------------------------------------- */
+#ifdef OS_POSIX
+namespace core {
+
+/**
+  The octets of a file, mapped read-only into memory, so that they can be read
+  in place (with the pointers from begin() and end() passed to e.g. readIeu()
+  and offset()) without being copied, or read before being used, and with the
+  pages shared with any other process that maps the file.
+
+  The file must not be truncated while it is mapped.
+*/
+class MappedFile {
+  /**
+    How the octets are expected to be read (which the kernel uses to decide how
+    far to read ahead and which pages to drop first).
+  */
+  pub enum class Access {
+    normal,
+    sequential,
+    random
+  };
+
+  prv const iu8f *ptr;
+  prv size_t size;
+
+  /**
+    Maps the file at {@p pathName}.
+
+    @throw PlainException if the file can't be opened or mapped.
+  */
+  pub explicit MappedFile (const char *pathName, Access access = Access::sequential);
+  MappedFile (const MappedFile &) = delete;
+  MappedFile &operator= (const MappedFile &) = delete;
+  pub MappedFile (MappedFile &&o) noexcept;
+  MappedFile &operator= (MappedFile &&) = delete;
+  pub ~MappedFile () noexcept;
+
+  pub const iu8f *begin () const noexcept;
+  pub const iu8f *end () const noexcept;
+  pub size_t getSize () const noexcept;
+
+  /**
+    Tells the kernel how the octets are now expected to be read.
+  */
+  pub void advise (Access access) noexcept;
+  /**
+    Tells the kernel that the octets [{@p i}, {@p end}) (which must be within
+    the file) will be read soon, so that it can start reading them in.
+  */
+  pub void prefetch (const iu8f *i, const iu8f *end) noexcept;
 };
 
 }
+#endif
 
 /* -----------------------------------------------------------------------------
    Characters
@@ -884,6 +2688,11 @@ template<typename _c> class string :
   */
   pub void resize_any (typename string<_c>::size_type count);
   pub size_t hashSlow () const noexcept;
+  pub size_t hashSlow (const HashKey &key) const noexcept;
+  /**
+    Feeds the string's characters, followed by its length, to the given Hasher.
+  */
+  pub void hashSlow (Hasher &r_hasher) const noexcept;
 };
 
 /**
@@ -895,6 +2704,213 @@ typedef string<char8_t> u8string;
 */
 typedef string<char32_t> u32string;
 
+/**
+  Instances hold a string that is built by appending to it and that is hashed
+  as it grows: the hash state is kept with the string (as a Hasher), so the
+  hash value is available after each append for the cost of hashing the
+  characters appended (rather than the whole string). The hash values are
+  those of the string itself, so HashWrapper<HashingString<_c>> and
+  HashWrapper<string<_c>> agree, and wrapping one with ::hashed() (or
+  releaseHashed()) doesn't hash it again.
+
+  Mutations that cannot be tracked (writing through the non-const data(), or
+  shrinking) discard the hash state, which is then rebuilt from the whole
+  string by the next append. Instances are large (the state includes a buffer
+  of Hasher::bufferCapacity octets), so they suit strings being built rather
+  than strings being stored.
+*/
+template<typename _c> class HashingString {
+  prv string<_c> s;
+  /**
+    The hash state of [0, hashedSize) (the characters after which have yet to
+    be fed to it, and are those of the last append).
+  */
+  prv Hasher hasher;
+  prv size_t hashedSize;
+
+  pub HashingString () noexcept;
+  pub explicit HashingString (string<_c> s) noexcept;
+
+  /**
+    Returns a reference to the string.
+  */
+  pub const string<_c> &get () const noexcept;
+  /**
+    Returns a string moved to from the string.
+  */
+  pub string<_c> release () && noexcept;
+  /**
+    Returns a HashWrapper wrapping a string moved to from the string (and
+    storing the hash value already computed).
+  */
+  pub HashWrapper<string<_c>> releaseHashed () &&;
+
+  pub const _c *data () const noexcept;
+  /**
+    Returns a pointer to the characters, for writing, which discards the hash
+    state (but characters just appended by append_any() can be written through
+    the pointer that it returns instead).
+  */
+  pub _c *data () noexcept;
+  pub size_t size () const noexcept;
+  pub const _c *begin () const noexcept;
+  pub const _c *end () const noexcept;
+
+  pub void append (const _c *i, const _c *end);
+  pub void append (const string<_c> &o);
+  pub void push_back (_c c);
+  /**
+    Appends the specified number of characters of unspecified value to the
+    string, returning a pointer to the first of them. The characters may be
+    written through the pointer until the string is next changed.
+  */
+  pub _c *append_any (size_t count);
+  /**
+    Resizes the string to contain the specified number of characters (which
+    must be no more than ::size()).
+  */
+  pub void truncate (size_t count) noexcept;
+  pub void clear () noexcept;
+
+  pub size_t hashSlow () const noexcept;
+  pub size_t hashSlow (const HashKey &key) const noexcept;
+  pub void hashSlow (Hasher &r_hasher) const noexcept;
+  pub bool operator== (const HashingString<_c> &r) const noexcept;
+
+  /**
+    Feeds the characters not yet hashed to the hash state.
+  */
+  prv void catchUp () noexcept;
+};
+
+}
+
+/* -----------------------------------------------------------------------------
+   Interning
+----------------------------------------------------------------------------- */
+namespace core {
+
+/**
+  A handle to a string held by an Interner (or ConcurrentInterner), which is
+  valid for the life of the interner. Handles from the same interner are equal
+  if and only if their strings are, so they are compared by pointer alone, and
+  they expose the hash value of the string (as for a HashWrapper of it).
+*/
+template<typename _c> class Interned {
+  prv class Header {
+    pub size_t h;
+    pub size_t size;
+  };
+
+  prv const _c *chars;
+
+  prv explicit Interned (const _c *chars) noexcept;
+
+  /**
+    Returns a pointer to the characters of the string (which are followed by a
+    null character).
+  */
+  pub const _c *data () const noexcept;
+  pub size_t size () const noexcept;
+  pub const _c *begin () const noexcept;
+  pub const _c *end () const noexcept;
+
+  pub size_t hashFast () const noexcept;
+  /**
+    Compares two instances (from the same interner) for equality.
+  */
+  pub bool operator== (const Interned<_c> &r) const noexcept;
+
+  template<typename _c2> friend class Interner;
+  template<typename _c2> friend class ConcurrentInterner;
+};
+
+/**
+  Holds one copy of each distinct string given to it, in blocks of storage that
+  never move, and hands out Interned handles to them. Strings are never removed
+  (other than by destroying the interner).
+*/
+template<typename _c> class Interner {
+  prv class Key {
+    pub const _c *chars;
+    pub size_t size;
+    pub size_t h;
+
+    pub size_t hashFast () const noexcept;
+    pub bool operator== (const Key &r) const noexcept;
+  };
+
+  prv static constexpr size_t blockSize = 4096;
+
+  prv FlatHashSet<Key> keys;
+  prv iu8f *lastBlock;
+  prv iu8f *blockPtr;
+  prv size_t blockLeft;
+
+  pub Interner () noexcept;
+  Interner (const Interner &) = delete;
+  Interner &operator= (const Interner &) = delete;
+  pub ~Interner () noexcept;
+
+  /**
+    Returns the handle to the string [{@p i}, {@p end}), copying it into the
+    interner if it isn't already held.
+  */
+  pub Interned<_c> intern (const _c *i, const _c *end);
+  pub Interned<_c> intern (const string<_c> &s);
+  /**
+    Returns the handle to the wrapped string (without hashing it again).
+  */
+  pub Interned<_c> intern (const HashWrapper<string<_c>> &s);
+  /**
+    Returns the handle to the string [{@p i}, {@p end}), if it is held.
+  */
+  pub std::optional<Interned<_c>> find (const _c *i, const _c *end) const;
+  /**
+    Returns the number of distinct strings held.
+  */
+  pub size_t size () const noexcept;
+
+  prv static size_t hashChars (const _c *i, size_t size) noexcept;
+  prv const _c *findHashed (const _c *i, size_t size, size_t h) const noexcept;
+  prv Interned<_c> internHashed (const _c *i, size_t size, size_t h);
+
+  template<typename _c2> friend class ConcurrentInterner;
+};
+
+/**
+  An Interner that can be used by many threads at once. Strings are spread
+  over shards by their hash values, each shard being an Interner with its own
+  reader-writer lock; interning a string that is already held only takes the
+  shard's lock for reading.
+*/
+template<typename _c> class ConcurrentInterner {
+  prv class alignas(64) Shard {
+    pub mutable std::shared_mutex mutex;
+    pub Interner<_c> interner;
+  };
+
+  prv std::unique_ptr<Shard[]> shards;
+  prv size_t shardMask;
+
+  /**
+    @param shardCount the number of shards (which is rounded up to a power of
+    two).
+  */
+  pub explicit ConcurrentInterner (size_t shardCount = 64);
+  ConcurrentInterner (const ConcurrentInterner &) = delete;
+  ConcurrentInterner &operator= (const ConcurrentInterner &) = delete;
+
+  pub Interned<_c> intern (const _c *i, const _c *end);
+  pub Interned<_c> intern (const string<_c> &s);
+  pub Interned<_c> intern (const HashWrapper<string<_c>> &s);
+  pub std::optional<Interned<_c>> find (const _c *i, const _c *end) const;
+  pub size_t size () const;
+
+  prv Interned<_c> internHashed (const _c *i, size_t size, size_t h);
+  prv Shard &getShard (size_t h) const noexcept;
+};
+
 }
 
 /* -----------------------------------------------------------------------------
@@ -1,5 +1,9 @@
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <utility>
 
 namespace core {
 
@@ -242,7 +246,62 @@ template<typename _i, typename _OutputIterator, bool _useSignedFormat> void writ
   } while (true);
 }
 
-template<typename _i, typename _InputIterator, typename _InputEndIterator, bool _validate, bool _useSignedFormat> std::tuple<_i, bool> readIex (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
+// Gathers the low 7 bits of each of the octets of a value into its low 56 bits.
+inline iu64f gatherIexGroups (iu64f v) noexcept {
+  #if defined(ARCH_X86) && defined(__BMI2__)
+  return _pext_u64(v, 0x7F7F7F7F7F7F7F7FULL);
+  #else
+  v = ((v & 0x7F007F007F007F00ULL) >> 1) | (v & 0x007F007F007F007FULL);
+  v = ((v & 0x3FFF00003FFF0000ULL) >> 2) | (v & 0x00003FFF00003FFFULL);
+  return ((v & 0x0FFFFFFF00000000ULL) >> 4) | (v & 0x0FFFFFFFULL);
+  #endif
+}
+
+// Reads a value from the word at r_ptr (which must have a word of octets
+// left), returning false (having read nothing) if the value is longer than a
+// word or overflows _i (leaving readIex() to read it, and to throw). Values of
+// one octet, which are the commonest, are handled before the word is loaded.
+template<typename _i, bool _useSignedFormat, typename _Pointer> bool readIexWord (_Pointer &r_ptr, std::tuple<_i, bool> &r_result) noexcept {
+  iu8f octet = *r_ptr;
+  if ((octet & 0x80) == 0) {
+    ++r_ptr;
+    if (_useSignedFormat) {
+      r_result = std::tuple<_i, bool>(static_cast<_i>(octet & 0x3F), (octet & 0x40) != 0);
+    } else {
+      r_result = std::tuple<_i, bool>(static_cast<_i>(octet), false);
+    }
+    return true;
+  }
+
+  iu64f word = get<iu64f>(r_ptr);
+  #ifdef ARCH_ENDIAN_BIG
+  word = __builtin_bswap64(word);
+  #endif
+  iu64f stops = ~word & 0x8080808080808080ULL;
+  if (stops == 0) {
+    return false;
+  }
+  auto lastOctetI = static_cast<iu>(__builtin_ctzll(stops)) >> 3;
+  word &= stops ^ (stops - 1);
+  bool isNegative = false;
+  if (_useSignedFormat) {
+    iu64f signBit = static_cast<iu64f>(0x40) << (lastOctetI * 8);
+    isNegative = ((word & signBit) != 0);
+    word &= ~signBit;
+  }
+  iu64f value = gatherIexGroups(word);
+  constexpr iu bits = numeric_limits<_i>::bits;
+  if constexpr (bits < 64) {
+    if (lastOctetI * 7 >= bits || (value >> bits) != 0) {
+      return false;
+    }
+  }
+  r_ptr += lastOctetI + 1;
+  r_result = std::tuple<_i, bool>(static_cast<_i>(value), isNegative);
+  return true;
+}
+
+template<typename _i, typename _InputIterator, typename _InputEndIterator, bool _validate, bool _useSignedFormat> std::tuple<_i, bool> readIexOctets (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
   DS();
   DSPRE(std::is_integral<_i>::value && std::is_unsigned<_i>::value, "_i must be an unsigned type");
   DW(, "reading ", _useSignedFormat ? "signed" : "unsigned", " value");
@@ -287,6 +346,60 @@ template<typename _i, typename _InputIterator, typename _InputEndIterator, bool
   } while (true);
 }
 
+// Contiguous octets are read a word at a time (which leaves the end of the
+// buffer to be checked only once), with the octet loop for the rest.
+template<typename _i, typename _InputIterator, typename _InputEndIterator, bool _validate, bool _useSignedFormat> std::tuple<_i, bool> readIex (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
+  if constexpr (_validate && std::is_pointer<_InputIterator>::value && std::is_pointer<typename std::remove_cv<_InputEndIterator>::type>::value) {
+    if (ptrEnd - r_ptr >= static_cast<ptrdiff_t>(sizeof(iu64f))) {
+      std::tuple<_i, bool> result;
+      if (core::readIexWord<_i, _useSignedFormat>(r_ptr, result)) {
+        return result;
+      }
+    }
+  }
+  return core::readIexOctets<_i, _InputIterator, _InputEndIterator, _validate, _useSignedFormat>(r_ptr, ptrEnd);
+}
+
+template<typename _i, bool _useSignedFormat> std::tuple<_i, bool> readIexWithinOctets (const iu8f *&r_ptr) {
+  const iu8f *ptr = r_ptr;
+  _i value = 0;
+  for (iu valueIndex = 0; valueIndex != static_cast<iu>(numeric_limits<_i>::max_ie_octets) * 7; valueIndex += 7) {
+    iu8f octet = *(ptr++);
+    if ((octet & 0x80) == 0) {
+      bool isNegative = false;
+      if (_useSignedFormat) {
+        isNegative = ((octet & 0x40) != 0);
+        octet = octet & 0x3F;
+      }
+
+      is topBitIndex = numeric_limits<_i>::bits - 1 - static_cast<is>(valueIndex);
+      if (topBitIndex < 7 && (octet >> (topBitIndex + 1)) != 0) {
+        throw std::overflow_error(string<char>(_useSignedFormat ? "signed" : "unsigned") + " external integer was too big");
+      }
+
+      r_ptr = ptr;
+      return std::tuple<_i, bool>(static_cast<_i>(value | static_cast<_i>(static_cast<_i>(octet) << valueIndex)), isNegative);
+    }
+
+    value = value | sl(static_cast<_i>(octet & 0x7F), valueIndex);
+  }
+  throw std::overflow_error(string<char>(_useSignedFormat ? "signed" : "unsigned") + " external integer was too big");
+}
+
+// Reads a value from r_ptr, which must have at least max_ie_octets octets left
+// before ptrEnd, so that only overflow needs checking (a value that doesn't end
+// within them overflows _i).
+template<typename _i, bool _useSignedFormat> std::tuple<_i, bool> readIexWithin (const iu8f *&r_ptr, const iu8f *ptrEnd) {
+  DPRE(offset(r_ptr, ptrEnd) >= static_cast<size_t>(numeric_limits<_i>::max_ie_octets), "the window must hold the longest value");
+  if (ptrEnd - r_ptr >= static_cast<ptrdiff_t>(sizeof(iu64f))) {
+    std::tuple<_i, bool> result;
+    if (core::readIexWord<_i, _useSignedFormat>(r_ptr, result)) {
+      return result;
+    }
+  }
+  return core::readIexWithinOctets<_i, _useSignedFormat>(r_ptr);
+}
+
 template<std::unsigned_integral _i, core::OutputIterator<iu8f> _OutputIterator> void writeIeu (_OutputIterator &r_ptr, _i value) noexcept(noexcept(*(r_ptr++))) {
   core::writeIex<_i, _OutputIterator, false>(r_ptr, value, false);
 }
@@ -322,10 +435,7 @@ template<
   return core::readIeuImpl<_i, _InputIterator, _InputIterator, false>(r_ptr, *static_cast<_InputIterator *>(nullptr));
 }
 
-template<typename _i, typename _InputIterator, typename _InputEndIterator, bool _validate> _i readIesImpl (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
-  typename std::make_unsigned<_i>::type mag;
-  bool isNegative;
-  std::tie(mag, isNegative) = core::readIex<decltype(mag), _InputIterator, _InputEndIterator, _validate, true>(r_ptr, ptrEnd);
+template<typename _i, bool _validate> _i getIesValue (typename std::make_unsigned<_i>::type mag, bool isNegative) {
   if (isNegative) {
     if (_validate && mag > static_cast<decltype(mag)>(-numeric_limits<_i>::min())) {
       throw std::overflow_error("signed external integer had too big a negative value");
@@ -339,6 +449,13 @@ template<typename _i, typename _InputIterator, typename _InputEndIterator, bool
   }
 }
 
+template<typename _i, typename _InputIterator, typename _InputEndIterator, bool _validate> _i readIesImpl (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
+  typename std::make_unsigned<_i>::type mag;
+  bool isNegative;
+  std::tie(mag, isNegative) = core::readIex<decltype(mag), _InputIterator, _InputEndIterator, _validate, true>(r_ptr, ptrEnd);
+  return core::getIesValue<_i, _validate>(mag, isNegative);
+}
+
 template<
   std::signed_integral _i, core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator
 > _i readIes (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd) {
@@ -353,6 +470,320 @@ template<
   return core::readIesImpl<_i, _InputIterator, _InputIterator, false>(r_ptr, *static_cast<_InputIterator *>(nullptr));
 }
 
+// Whatever the block decoder leaves is read singly (which is where invalid
+// input is thrown on), and then the block decoder is tried again.
+template<std::unsigned_integral _i> void readIeuArray (const iu8f *&r_ptr, const iu8f *ptrEnd, _i *out, size_t count) {
+  _i *outEnd = out + count;
+  while (out != outEnd) {
+    if constexpr (std::same_as<_i, iu32f> || std::same_as<_i, iu64f>) {
+      out += readIeuBlock(r_ptr, ptrEnd, out, offset(out, outEnd));
+      if (out == outEnd) {
+        break;
+      }
+    }
+    *(out++) = readIeu<_i>(r_ptr, ptrEnd);
+  }
+}
+
+template<std::signed_integral _i> void readIesArray (const iu8f *&r_ptr, const iu8f *ptrEnd, _i *out, size_t count) {
+  _i *outEnd = out + count;
+  while (out != outEnd) {
+    if constexpr (std::same_as<_i, is32f> || std::same_as<_i, is64f>) {
+      out += readIesBlock(r_ptr, ptrEnd, out, offset(out, outEnd));
+      if (out == outEnd) {
+        break;
+      }
+    }
+    *(out++) = readIes<_i>(r_ptr, ptrEnd);
+  }
+}
+
+// Splits a value into its magnitude and sign (for the signed format, which
+// holds both).
+template<typename _i> constexpr std::tuple<typename std::make_unsigned<_i>::type, bool> getIexMagnitude (_i value) noexcept {
+  typedef typename std::make_unsigned<_i>::type U;
+  if constexpr (std::is_signed<_i>::value) {
+    if (value < 0) {
+      return std::tuple<U, bool>(static_cast<U>(0U - static_cast<U>(value)), true);
+    }
+  }
+  return std::tuple<U, bool>(static_cast<U>(value), false);
+}
+
+// Returns the number of octets that writeIex() writes for a magnitude (the
+// signed format having one fewer bit in the final octet).
+template<bool _useSignedFormat> constexpr size_t getIexSize (iu64f mag) noexcept {
+  auto bitCount = static_cast<size_t>(std::bit_width(mag | 1));
+  return (bitCount + (_useSignedFormat ? 7 : 6)) / 7;
+}
+
+template<std::unsigned_integral _i> constexpr size_t getIeuSize (_i value) noexcept {
+  return core::getIexSize<false>(static_cast<iu64f>(value));
+}
+
+template<std::signed_integral _i> constexpr size_t getIesSize (_i value) noexcept {
+  return core::getIexSize<true>(static_cast<iu64f>(std::get<0>(core::getIexMagnitude(value))));
+}
+
+// Spreads the low 56 bits of a value over 8 octets, 7 to each.
+inline iu64f spreadIexGroups (iu64f v) noexcept {
+  return
+    (v & 0x7F) | ((v << 1) & 0x7F00) | ((v << 2) & 0x7F0000) | ((v << 3) & 0x7F000000) |
+    ((v << 4) & 0x7F00000000ULL) | ((v << 5) & 0x7F0000000000ULL) | ((v << 6) & 0x7F000000000000ULL) | ((v << 7) & 0x7F00000000000000ULL);
+}
+
+template<bool _useSignedFormat, typename _i> size_t getIexArraySize (const _i *in, size_t count) noexcept {
+  size_t size = 0;
+  for (size_t n = 0; n != count; ++n) {
+    size += getIexSize<_useSignedFormat>(static_cast<iu64f>(std::get<0>(getIexMagnitude(in[n]))));
+  }
+  return size;
+}
+
+// Values are built in a word (with their continuation bits, and sign bits) and
+// written with one store, which writes past their ends (so the last few
+// values, within a word of the end of the buffer, are written an octet at a
+// time). Values of more than 8 octets have their top octets written singly.
+template<bool _useSignedFormat, typename _i> void writeIexArray (iu8f *&r_ptr, const iu8f *ptrEnd, const _i *in, size_t count) noexcept {
+  typedef typename std::make_unsigned<_i>::type U;
+  DSA(sizeof(U) <= sizeof(iu64f), "_i must fit in a word");
+
+  iu8f *ptr = r_ptr;
+  for (size_t n = 0; n != count; ++n) {
+    auto [mag, isNegative] = getIexMagnitude(in[n]);
+    if (offset(static_cast<const iu8f *>(ptr), ptrEnd) < sizeof(iu64f)) {
+      core::writeIex<U, iu8f *, _useSignedFormat>(ptr, mag, isNegative);
+      continue;
+    }
+
+    size_t size = getIexSize<_useSignedFormat>(static_cast<iu64f>(mag));
+    iu64f word;
+    if (size <= 8) {
+      size_t lastOctetI = size - 1;
+      word = spreadIexGroups(static_cast<iu64f>(mag)) | (0x8080808080808080ULL & ((static_cast<iu64f>(1) << (lastOctetI * 8)) - 1));
+      if (_useSignedFormat) {
+        word |= static_cast<iu64f>(isNegative) << (lastOctetI * 8 + 6);
+      }
+    } else {
+      word = spreadIexGroups(static_cast<iu64f>(mag)) | 0x8080808080808080ULL;
+    }
+    #ifdef ARCH_ENDIAN_BIG
+    word = __builtin_bswap64(word);
+    #endif
+    set<iu64f>(ptr, word);
+    if (size <= 8) {
+      ptr += size;
+    } else {
+      ptr += 8;
+      core::writeIex<iu64f, iu8f *, _useSignedFormat>(ptr, static_cast<iu64f>(mag) >> 56, isNegative);
+    }
+  }
+  r_ptr = ptr;
+}
+
+template<std::unsigned_integral _i> size_t getIeuArraySize (const _i *in, size_t count) noexcept {
+  return core::getIexArraySize<false>(in, count);
+}
+
+template<std::signed_integral _i> size_t getIesArraySize (const _i *in, size_t count) noexcept {
+  return core::getIexArraySize<true>(in, count);
+}
+
+template<std::unsigned_integral _i> void writeIeuArray (iu8f *&r_ptr, const iu8f *ptrEnd, const _i *in, size_t count) noexcept {
+  core::writeIexArray<false>(r_ptr, ptrEnd, in, count);
+}
+
+template<std::signed_integral _i> void writeIesArray (iu8f *&r_ptr, const iu8f *ptrEnd, const _i *in, size_t count) noexcept {
+  core::writeIexArray<true>(r_ptr, ptrEnd, in, count);
+}
+
+template<typename _Octets, std::unsigned_integral _i> requires requires (_Octets &r_octets, size_t size) {
+  r_octets.resize(size);
+  {r_octets.data()} -> std::same_as<iu8f *>;
+} void writeIeuArray (_Octets &r_octets, const _i *in, size_t count) {
+  size_t oldSize = r_octets.size();
+  r_octets.resize(oldSize + getIeuArraySize(in, count));
+  iu8f *ptr = r_octets.data() + oldSize;
+  writeIeuArray(ptr, r_octets.data() + r_octets.size(), in, count);
+}
+
+template<typename _Octets, std::signed_integral _i> requires requires (_Octets &r_octets, size_t size) {
+  r_octets.resize(size);
+  {r_octets.data()} -> std::same_as<iu8f *>;
+} void writeIesArray (_Octets &r_octets, const _i *in, size_t count) {
+  size_t oldSize = r_octets.size();
+  r_octets.resize(oldSize + getIesArraySize(in, count));
+  iu8f *ptr = r_octets.data() + oldSize;
+  writeIesArray(ptr, r_octets.data() + r_octets.size(), in, count);
+}
+
+// Values of up to 56 bits take 1 to 8 octets, whose little-endian word is the
+// value shifted up by the number of octets, with a 1 bit just below it (so the
+// first octet has one fewer trailing zeroes than there are octets). Bigger
+// values take a zero octet and then the 8 octets of the value.
+constexpr size_t getIpxSize (iu64f value) noexcept {
+  auto bitCount = static_cast<size_t>(std::bit_width(value | 1));
+  return bitCount > 56 ? 9 : (bitCount + 6) / 7;
+}
+
+// Interleaves the (two's complement) values of a type with their negations
+// (0, -1, 1, -2...), so that small magnitudes make small unsigned values.
+template<std::unsigned_integral _i> constexpr _i encodeZigzag (_i value) noexcept {
+  return static_cast<_i>(static_cast<_i>(value << 1) ^ static_cast<_i>(0U - (value >> (numeric_limits<_i>::bits - 1))));
+}
+
+template<std::unsigned_integral _i> constexpr _i decodeZigzag (_i value) noexcept {
+  return static_cast<_i>((value >> 1) ^ static_cast<_i>(0U - (value & 1U)));
+}
+
+template<typename _OutputIterator> void writeIpx (_OutputIterator &r_ptr, iu64f value) {
+  size_t size = getIpxSize(value);
+  iu64f word;
+  if (size == 9) {
+    *(r_ptr++) = 0;
+    word = value;
+    size = 8;
+  } else {
+    word = (value << size) | (static_cast<iu64f>(1) << (size - 1));
+  }
+  for (size_t i = 0; i != size; ++i) {
+    *(r_ptr++) = static_cast<iu8f>(word >> (i * 8));
+  }
+}
+
+template<typename _InputIterator, typename _InputEndIterator, bool _validate, bool _useSignedFormat> iu64f readIpxOctets (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
+  if (_validate && r_ptr == ptrEnd) {
+    throw PlainException(u8string(_useSignedFormat ? u8"signed" : u8"unsigned") + u8" prefix-length external integer was truncated");
+  }
+  iu8f octet = *(r_ptr++);
+  auto size = static_cast<iu>(std::countr_zero(static_cast<iu>(octet) | 0x100)) + 1;
+  iu64f value = 0;
+  iu shift = 0;
+  if (size != 9) {
+    value = static_cast<iu64f>(octet >> size);
+    shift = 8 - size;
+  }
+  for (iu i = 1; i != size; ++i) {
+    if (_validate && r_ptr == ptrEnd) {
+      throw PlainException(u8string(_useSignedFormat ? u8"signed" : u8"unsigned") + u8" prefix-length external integer was truncated");
+    }
+    value |= static_cast<iu64f>(*(r_ptr++)) << shift;
+    shift += 8;
+  }
+  return value;
+}
+
+// Contiguous octets are read with one load (when there's room for a word),
+// with the octet loop for the rest.
+template<typename _InputIterator, typename _InputEndIterator, bool _validate, bool _useSignedFormat> iu64f readIpx (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
+  if constexpr (_validate && std::is_pointer<_InputIterator>::value && std::is_pointer<typename std::remove_cv<_InputEndIterator>::type>::value) {
+    if (ptrEnd - r_ptr >= static_cast<ptrdiff_t>(sizeof(iu64f))) {
+      iu64f word = get<iu64f>(r_ptr);
+      #ifdef ARCH_ENDIAN_BIG
+      word = __builtin_bswap64(word);
+      #endif
+      auto size = static_cast<iu>(std::countr_zero(static_cast<iu>(word & 0xFF) | 0x100)) + 1;
+      if (size != 9) {
+        r_ptr += size;
+        return (word & (~static_cast<iu64f>(0) >> (64 - size * 8))) >> size;
+      }
+    }
+  }
+  return core::readIpxOctets<_InputIterator, _InputEndIterator, _validate, _useSignedFormat>(r_ptr, ptrEnd);
+}
+
+template<typename _i, typename _InputIterator, typename _InputEndIterator, bool _validate> _i readIpuImpl (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
+  iu64f value = core::readIpx<_InputIterator, _InputEndIterator, _validate, false>(r_ptr, ptrEnd);
+  if (_validate && value > static_cast<iu64f>(numeric_limits<_i>::max())) {
+    throw std::overflow_error("unsigned prefix-length external integer was too big");
+  }
+  return static_cast<_i>(value);
+}
+
+template<typename _i, typename _InputIterator, typename _InputEndIterator, bool _validate> _i readIpsImpl (_InputIterator &r_ptr, _InputEndIterator &ptrEnd) {
+  auto value = static_cast<is64f>(decodeZigzag(core::readIpx<_InputIterator, _InputEndIterator, _validate, true>(r_ptr, ptrEnd)));
+  if (_validate && (value < static_cast<is64f>(numeric_limits<_i>::min()) || value > static_cast<is64f>(numeric_limits<_i>::max()))) {
+    throw std::overflow_error("signed prefix-length external integer was out of range");
+  }
+  return static_cast<_i>(value);
+}
+
+template<std::unsigned_integral _i, core::OutputIterator<iu8f> _OutputIterator> void writeIpu (_OutputIterator &r_ptr, _i value) noexcept(noexcept(*(r_ptr++))) {
+  core::writeIpx(r_ptr, static_cast<iu64f>(value));
+}
+
+template<std::signed_integral _i, core::OutputIterator<iu8f> _OutputIterator> void writeIps (_OutputIterator &r_ptr, _i value) noexcept(noexcept(*(r_ptr++))) {
+  core::writeIpx(r_ptr, encodeZigzag(static_cast<iu64f>(static_cast<is64f>(value))));
+}
+
+template<
+  std::unsigned_integral _i, core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator
+> _i readIpu (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd) {
+  return core::readIpuImpl<_i, _InputIterator, const _InputEndIterator, true>(r_ptr, ptrEnd);
+}
+
+template<
+  std::unsigned_integral _i, core::InputIterator<iu8f> _InputIterator
+> requires requires (_InputIterator i) {
+  {*(i++)} noexcept;
+} _i readValidIpu (_InputIterator &r_ptr) noexcept {
+  return core::readIpuImpl<_i, _InputIterator, _InputIterator, false>(r_ptr, *static_cast<_InputIterator *>(nullptr));
+}
+
+template<
+  std::signed_integral _i, core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator
+> _i readIps (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd) {
+  return core::readIpsImpl<_i, _InputIterator, const _InputEndIterator, true>(r_ptr, ptrEnd);
+}
+
+template<
+  std::signed_integral _i, core::InputIterator<iu8f> _InputIterator
+> requires requires (_InputIterator i) {
+  {*(i++)} noexcept;
+} _i readValidIps (_InputIterator &r_ptr) noexcept {
+  return core::readIpsImpl<_i, _InputIterator, _InputIterator, false>(r_ptr, *static_cast<_InputIterator *>(nullptr));
+}
+
+template<std::unsigned_integral _i> constexpr size_t getIpuSize (_i value) noexcept {
+  return core::getIpxSize(static_cast<iu64f>(value));
+}
+
+template<std::signed_integral _i> constexpr size_t getIpsSize (_i value) noexcept {
+  return core::getIpxSize(encodeZigzag(static_cast<iu64f>(static_cast<is64f>(value))));
+}
+
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIeuToIpu (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count) {
+  for (size_t n = 0; n != count; ++n) {
+    writeIpu(r_out, readIeu<iu64f>(r_ptr, ptrEnd));
+  }
+}
+
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIpuToIeu (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count) {
+  for (size_t n = 0; n != count; ++n) {
+    writeIeu(r_out, readIpu<iu64f>(r_ptr, ptrEnd));
+  }
+}
+
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIesToIps (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count) {
+  for (size_t n = 0; n != count; ++n) {
+    writeIps(r_out, readIes<is64f>(r_ptr, ptrEnd));
+  }
+}
+
+template<
+  core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator, core::OutputIterator<iu8f> _OutputIterator
+> void convertIpsToIes (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd, _OutputIterator &r_out, size_t count) {
+  for (size_t n = 0; n != count; ++n) {
+    writeIes(r_out, readIps<is64f>(r_ptr, ptrEnd));
+  }
+}
+
 /* -----------------------------------------------------------------------------
 ----------------------------------------------------------------------------- */
 namespace finally {
@@ -375,7 +806,7 @@ template<typename _F> Finally<_F>::~Finally () noexcept {
 }
 
 template<typename _F> Finally<_F> finallyImpl (_F &&functor) {
-  return Finally<_F>(move(functor));
+  return Finally<_F>(std::move(functor));
 }
 
 }
@@ -404,98 +835,1883 @@ template<typename _T> size_t offset (_T *first, _T *last) noexcept {
 
 /* -----------------------------------------------------------------------------
 ----------------------------------------------------------------------------- */
-template<typename _T> template<typename ..._Ts> requires requires (_Ts &&...ts) {
-  {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
-} SlowHashWrapper<_T>::SlowHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)) && noexcept(hashSlow(o))) :
-  o(std::forward<_Ts>(ts)...), h(hashSlow(o))
-{
+// The hash engine works on 64-bit words, whatever the width of size_t. Inputs
+// of up to 128 octets are folded 8 or 16 octets at a time with 64x64->128-bit
+// multiplies. Longer inputs are consumed in 32-octet stripes by four independent
+// accumulator lanes (each round being a 32x32->64-bit multiply of the halves
+// of a keyed input word, plus the unkeyed word added to the neighbouring lane),
+// which are scrambled every block of 16 stripes and merged at the end. All
+// multi-octet reads are little-endian, so the result doesn't depend on the
+// alignment of the input.
+//
+// Everything here is constexpr. During constant evaluation, words are
+// assembled octet by octet (since memory can't be reinterpreted) and long
+// inputs always take the scalar path; otherwise, words are loaded directly and
+// long inputs go to the kernel in use. The results are identical.
+namespace hashing {
+
+template<Octet _c> constexpr iu64f read64 (const _c *ptr) noexcept {
+  if (std::is_constant_evaluated()) {
+    iu64f value = 0;
+    for (iu j = 8; j-- != 0;) {
+      value = (value << 8) | static_cast<iu8f>(ptr[j]);
+    }
+    return value;
+  }
+
+  iu64f value = get<iu64f>(reinterpret_cast<const iu8f *>(ptr));
+  #ifdef ARCH_ENDIAN_BIG
+  value = __builtin_bswap64(value);
+  #endif
+  return value;
 }
 
-template<typename _T> const _T &SlowHashWrapper<_T>::get () const noexcept {
-  return o;
+template<Octet _c> constexpr iu64f read32 (const _c *ptr) noexcept {
+  if (std::is_constant_evaluated()) {
+    iu64f value = 0;
+    for (iu j = 4; j-- != 0;) {
+      value = (value << 8) | static_cast<iu8f>(ptr[j]);
+    }
+    return value;
+  }
+
+  iu32f value = get<iu32f>(reinterpret_cast<const iu8f *>(ptr));
+  #ifdef ARCH_ENDIAN_BIG
+  value = __builtin_bswap32(value);
+  #endif
+  return value;
 }
 
-template<typename _T> _T SlowHashWrapper<_T>::release () && noexcept {
-  return std::move(o);
+constexpr iu64f rotl64 (iu64f value, iu sh) noexcept {
+  return (value << sh) | (value >> (64 - sh));
 }
 
-template<typename _T> size_t SlowHashWrapper<_T>::hashFast () const noexcept {
-  return h;
+// Multiplies two values to 128 bits and folds the halves of the product together.
+constexpr iu64f mum (iu64f l, iu64f r) noexcept {
+  #ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 iu128f;
+  iu128f product = static_cast<iu128f>(l) * r;
+  return static_cast<iu64f>(product) ^ static_cast<iu64f>(product >> 64);
+  #else
+  iu64f lL = l & 0xFFFFFFFF, lH = l >> 32, rL = r & 0xFFFFFFFF, rH = r >> 32;
+  iu64f ll = lL * rL, lh = lL * rH, hl = lH * rL, hh = lH * rH;
+  iu64f mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+  return ((ll & 0xFFFFFFFF) | (mid << 32)) ^ (hh + (lh >> 32) + (hl >> 32) + (mid >> 32));
+  #endif
 }
 
-template<typename _T> bool SlowHashWrapper<_T>::operator== (const SlowHashWrapper<_T> &r) const noexcept(noexcept(r.get() == r.get())) {
-  return hashFast() == r.hashFast() && get() == r.get();
+constexpr iu64f avalanche (iu64f h) noexcept {
+  h ^= h >> 37;
+  h *= hashPrime2;
+  return h ^ (h >> 32);
 }
 
-template<typename _T> template<typename ..._Ts> requires requires (_Ts &&...ts) {
-  {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
-} FastHashWrapper<_T>::FastHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...))) :
-  o(std::forward<_Ts>(ts)...)
-{
+constexpr iu64f avalancheStrongly (iu64f h) noexcept {
+  h ^= h >> 33;
+  h *= hashPrime1;
+  h ^= h >> 29;
+  h *= hashPrime2;
+  return h ^ (h >> 32);
 }
 
-template<typename _T> const _T &FastHashWrapper<_T>::get () const noexcept {
-  return o;
+// The values are distinct and have about half of their bits set.
+constexpr RollingHashTable createRollingHashTable () noexcept {
+  RollingHashTable table{};
+  for (iu i = 0; i != 256; ++i) {
+    table.values[i] = avalancheStrongly((static_cast<iu64f>(i) + 1) * hashPrime0);
+  }
+  return table;
 }
 
-template<typename _T> _T FastHashWrapper<_T>::release () && noexcept {
-  return std::move(o);
+inline constexpr RollingHashTable rollingHashTable = createRollingHashTable();
+
+template<Octet _c> constexpr iu64f mix16 (const _c *ptr, const iu64f *key) noexcept {
+  return mum(read64(ptr) ^ key[0], read64(ptr + 8) ^ key[1]);
 }
 
-template<typename _T> size_t FastHashWrapper<_T>::hashFast () const noexcept {
-  using core::hashFast;
-  DSPRE(noexcept(hashFast(o)), "");
-  return hashFast(o);
+template<Octet _c> constexpr iu64f hash0To3 (const _c *ptr, size_t size, const iu64f *secret) noexcept {
+  if (size > 0) {
+    iu64f v = (static_cast<iu64f>(static_cast<iu8f>(ptr[0])) << 16) | (static_cast<iu64f>(static_cast<iu8f>(ptr[size >> 1])) << 24) | static_cast<iu8f>(ptr[size - 1]) | (static_cast<iu64f>(size) << 8);
+    return avalancheStrongly(v ^ secret[0]);
+  }
+  return avalancheStrongly(secret[0] ^ secret[1]);
 }
 
-template<typename _T> bool FastHashWrapper<_T>::operator== (const FastHashWrapper<_T> &r) const noexcept(noexcept(r.get() == r.get())) {
-  return get() == r.get();
+template<Octet _c> constexpr iu64f hash4To8 (const _c *ptr, size_t size, const iu64f *secret) noexcept {
+  iu64f v = ((read32(ptr) << 32) | read32(ptr + size - 4)) ^ secret[1];
+  v ^= rotl64(v, 49) ^ rotl64(v, 24);
+  v *= hashPrime3;
+  v ^= (v >> 35) + static_cast<iu64f>(size);
+  v *= hashPrime3;
+  return v ^ (v >> 28);
 }
 
-/* -----------------------------------------------------------------------------
------------------------------------------------------------------------------ */
-template<typename _c> template<typename ..._Ts> string<_c>::string (_Ts &&...ts) :
-  std::basic_string<_c>(std::forward<_Ts>(ts)...)
-{
+template<Octet _c> constexpr iu64f hash9To16 (const _c *ptr, size_t size, const iu64f *secret) noexcept {
+  iu64f l = read64(ptr) ^ secret[2];
+  iu64f h = read64(ptr + size - 8) ^ secret[3];
+  return avalanche(static_cast<iu64f>(size) + rotl64(l, 32) + h + mum(l, h));
 }
 
-template<typename _c> string<_c>::string (typename string<_c>::size_type capacity) {
-  this->reserve(capacity);
+template<Octet _c> constexpr iu64f hash0To16 (const _c *ptr, size_t size, const iu64f *secret) noexcept {
+  if (size > 8) {
+    return hash9To16(ptr, size, secret);
+  }
+  if (size >= 4) {
+    return hash4To8(ptr, size, secret);
+  }
+  return hash0To3(ptr, size, secret);
 }
 
-template<typename _c> string<_c>::string (const string<_c> &o) : string<_c>(o.size()) {
-  this->append(o);
+template<Octet _c> constexpr iu64f hash17To128 (const _c *ptr, size_t size, const iu64f *secret) noexcept {
+  iu64f acc = static_cast<iu64f>(size) * hashPrime0;
+  size_t i = 0;
+  for (; i + 16 < size; i += 16) {
+    acc += mix16(ptr + i, secret + i / 8);
+  }
+  acc += mix16(ptr + size - 16, secret + 14);
+  return avalanche(acc);
 }
 
-template<typename _c> string<_c>::string (string<_c> &o) : string<_c>(static_cast<const string<_c> &>(o)) {
+template<Octet _c> constexpr void accumulateStripe (iu64f *acc, const _c *ptr, const iu64f *key) noexcept {
+  for (iu j = 0; j != 4; ++j) {
+    iu64f d = read64(ptr + j * 8);
+    iu64f dk = d ^ key[j];
+    acc[j ^ 1] += d;
+    acc[j] += (dk & 0xFFFFFFFF) * (dk >> 32);
+  }
 }
 
-template<typename _c> typename string<_c>::reference string<_c>::operator[] (typename string<_c>::size_type pos) {
-  DPRE(pos < this->size());
-  return std::basic_string<_c>::operator[](pos);
+constexpr void scrambleAccumulators (iu64f *acc, const iu64f *key) noexcept {
+  for (iu j = 0; j != 4; ++j) {
+    acc[j] = (acc[j] ^ (acc[j] >> 47) ^ key[j]) * hashPrime32;
+  }
 }
 
-template<typename _c> typename string<_c>::const_reference string<_c>::operator[] (typename string<_c>::size_type pos) const {
-  DPRE(pos < this->size());
-  return std::basic_string<_c>::operator[](pos);
+// The stripe kernels each consume the run of stripes [stripeI, stripeEnd)
+// (numbered from the start of the input), scrambling the accumulators at the
+// end of every complete block. They must all give bit-identical results.
+template<Octet _c> constexpr void accumulateStripesScalar (iu64f *acc, const _c *ptr, size_t stripeI, size_t stripeEnd, const iu64f *secret) noexcept {
+  for (; stripeI != stripeEnd; ++stripeI, ptr += hashStripeSize) {
+    accumulateStripe(acc, ptr, secret + (stripeI & 7));
+    if ((stripeI + 1) % hashBlockStripeCount == 0) {
+      scrambleAccumulators(acc, secret + 8);
+    }
+  }
 }
 
-template<typename _c> _c *string<_c>::data () {
-  return &std::basic_string<_c>::operator[](0);
+constexpr void initAccumulators (iu64f *acc) noexcept {
+  acc[0] = hashPrime32;
+  acc[1] = hashPrime0;
+  acc[2] = hashPrime1;
+  acc[3] = hashPrime2;
 }
 
-template<typename _c> void string<_c>::append_any (typename string<_c>::size_type count) {
-  this->append(count, static_cast<_c>(0x58));
+// Consumes the final stripe (the last hashStripeSize octets of the input,
+// which may overlap those already consumed) and merges the accumulators.
+template<Octet _c> constexpr iu64f finishAccumulators (iu64f *acc, const _c *lastStripe, size_t size, const iu64f *secret) noexcept {
+  accumulateStripe(acc, lastStripe, secret + 11);
+
+  iu64f h = static_cast<iu64f>(size) * hashPrime0;
+  h += mum(acc[0] ^ secret[12], acc[1] ^ secret[13]);
+  h += mum(acc[2] ^ secret[14], acc[3] ^ secret[15]);
+  return avalanche(h);
 }
 
-template<typename _c> void string<_c>::resize_any (typename string<_c>::size_type count) {
-  this->resize(count, static_cast<_c>(0x58));
+template<Octet _c> constexpr iu64f hashLong (const _c *ptr, size_t size, const iu64f *secret) noexcept {
+  iu64f acc[4] = {};
+  initAccumulators(acc);
+
+  // Leave at least one octet for the final (possibly partial) stripe.
+  size_t stripeEnd = (size - 1) / hashStripeSize;
+  if (std::is_constant_evaluated()) {
+    accumulateStripesScalar(acc, ptr, 0, stripeEnd, secret);
+  } else {
+    accumulateStripes(acc, reinterpret_cast<const iu8f *>(ptr), 0, stripeEnd, secret);
+  }
+  return finishAccumulators(acc, ptr + size - hashStripeSize, size, secret);
 }
 
-template<typename _c> size_t string<_c>::hashSlow () const noexcept {
-  const _c *begin = this->data();
-  const _c *end = begin + this->size();
-  return hash(reinterpret_cast<const iu8f *>(begin), reinterpret_cast<const iu8f *>(end));
+template<Octet _c> constexpr size_t hashWithSecret (const _c *ptr, size_t size, const iu64f *secret) noexcept {
+  iu64f h;
+  if (size <= 16) {
+    h = hash0To16(ptr, size, secret);
+  } else if (size <= 128) {
+    h = hash17To128(ptr, size, secret);
+  } else {
+    h = hashLong(ptr, size, secret);
+  }
+  return static_cast<size_t>(h);
+}
+
+}
+
+template<hashing::Octet _c> constexpr size_t hash (const _c *i, const _c *end) noexcept {
+  return hashing::hashWithSecret(i, static_cast<size_t>(end - i), hashing::hashSecret);
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<std::integral _i> void Hasher::update (_i value) noexcept {
+  auto v = static_cast<typename std::make_unsigned<_i>::type>(value);
+  iu8f b[sizeof(_i)];
+  for (size_t i = 0; i != sizeof(_i); ++i) {
+    b[i] = static_cast<iu8f>(v);
+    v = static_cast<decltype(v)>(sr(v, 8));
+  }
+  update(b, b + sizeof(_i));
+}
+
+template<typename _T> requires requires (const _T &o, Hasher &r_hasher) {
+  o.hashSlow(r_hasher);
+} void Hasher::update (const _T &o) noexcept(noexcept(o.hashSlow(std::declval<Hasher &>()))) {
+  o.hashSlow(*this);
+}
+
+inline RollingHash::RollingHash (size_t windowSize) noexcept : windowSize(windowSize), h(0) {
+}
+
+inline void RollingHash::push (iu8f in) noexcept {
+  h = hashing::rotl64(h, 1) ^ hashing::rollingHashTable.values[in];
+}
+
+// The value of the octet leaving the window has been rotated once per octet
+// since it was pushed, so is removed by rotating it as far.
+inline void RollingHash::roll (iu8f out, iu8f in) noexcept {
+  iu64f o = hashing::rollingHashTable.values[out];
+  iu sh = static_cast<iu>(windowSize % 64);
+  o = (o << sh) | (o >> ((64 - sh) % 64));
+  h = hashing::rotl64(h, 1) ^ o ^ hashing::rollingHashTable.values[in];
+}
+
+inline size_t RollingHash::get () const noexcept {
+  return static_cast<size_t>(h);
+}
+
+template<core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator> bool Chunker::update (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd) noexcept(noexcept(*(r_ptr++)) && noexcept(r_ptr != ptrEnd)) {
+  if constexpr (std::contiguous_iterator<_InputIterator> && std::sized_sentinel_for<_InputEndIterator, _InputIterator>) {
+    const iu8f *begin = std::to_address(r_ptr);
+    const iu8f *i = begin;
+    bool found = scan(i, begin + (ptrEnd - r_ptr));
+    r_ptr += i - begin;
+    return found;
+  } else {
+    // Octets can't be put back, so each is scanned before the next is read.
+    while (r_ptr != ptrEnd) {
+      iu8f b = *(r_ptr++);
+      const iu8f *i = &b;
+      if (scan(i, i + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+template<typename _T> requires requires (const _T &o, Hasher &r_hasher) {
+  o.hashSlow(r_hasher);
+} && (!requires (const _T &o) {
+  o.hashSlow();
+}) size_t hashSlow (const _T &o) noexcept(noexcept(o.hashSlow(std::declval<Hasher &>()))) {
+  Hasher hasher;
+  o.hashSlow(hasher);
+  return hasher.finish();
+}
+
+template<typename _T> requires requires (const _T &o, Hasher &r_hasher) {
+  o.hashSlow(r_hasher);
+} && (!requires (const _T &o, const HashKey &key) {
+  o.hashSlow(key);
+}) size_t hashSlow (const _T &o, const HashKey &key) noexcept(noexcept(o.hashSlow(std::declval<Hasher &>()))) {
+  Hasher hasher(key);
+  o.hashSlow(hasher);
+  return hasher.finish();
+}
+
+// The multiplication and the avalanche are both invertible, so distinct
+// values of h stay distinct, and the product spreads the seed over the high
+// bits before the avalanche brings them down.
+constexpr size_t combineHashes (size_t seed, size_t h) noexcept {
+  return static_cast<size_t>(hashing::avalancheStrongly(static_cast<iu64f>(seed) * hashing::hashPrime3 + static_cast<iu64f>(h)));
+}
+
+template<FastHashable _T> size_t ElementHasher<_T>::hash (const _T &o) noexcept {
+  return hashFast(o);
+}
+
+template<FastHashable _T> size_t ElementHasher<_T>::hash (const _T &o, const HashKey &key) noexcept {
+  return mixHash(hashFast(o), key);
+}
+
+template<typename _T> requires (!isHashedViaElements<_T> && !FastHashable<_T> && SlowHashable<_T>) size_t ElementHasher<_T>::hash (const _T &o) noexcept(noexcept(hashSlow(o))) {
+  return hashSlow(o);
+}
+
+template<typename _T> requires (!isHashedViaElements<_T> && !FastHashable<_T> && SlowHashable<_T>) size_t ElementHasher<_T>::hash (const _T &o, const HashKey &key) noexcept(noexcept(hashSlow(o, key))) requires KeyedSlowHashable<_T> {
+  return hashSlow(o, key);
+}
+
+template<typename _T> requires std::integral<_T> || std::is_enum_v<_T> size_t ElementHasher<_T>::hash (_T o) noexcept {
+  return static_cast<size_t>(hashing::avalancheStrongly(static_cast<iu64f>(o) * hashing::hashPrime0));
+}
+
+template<typename _T> requires std::integral<_T> || std::is_enum_v<_T> size_t ElementHasher<_T>::hash (_T o, const HashKey &key) noexcept {
+  return mixHash(static_cast<size_t>(o), key);
+}
+
+template<typename _T0, typename _T1> size_t ElementHasher<std::pair<_T0, _T1>>::hash (const std::pair<_T0, _T1> &o) noexcept(noexcept(
+  ElementHasher<std::tuple<const _T0 &, const _T1 &>>::hash(std::tie(o.first, o.second))
+)) requires ElementHashable<_T0> && ElementHashable<_T1> {
+  return ElementHasher<std::tuple<const _T0 &, const _T1 &>>::hash(std::tie(o.first, o.second));
+}
+
+template<typename _T0, typename _T1> size_t ElementHasher<std::pair<_T0, _T1>>::hash (const std::pair<_T0, _T1> &o, const HashKey &key) noexcept(noexcept(
+  ElementHasher<std::tuple<const _T0 &, const _T1 &>>::hash(std::tie(o.first, o.second), key)
+)) requires KeyedElementHashable<_T0> && KeyedElementHashable<_T1> {
+  return ElementHasher<std::tuple<const _T0 &, const _T1 &>>::hash(std::tie(o.first, o.second), key);
+}
+
+template<typename ..._Ts> size_t ElementHasher<std::tuple<_Ts...>>::hash (const std::tuple<_Ts...> &o) noexcept((
+  noexcept(ElementHasher<std::remove_cvref_t<_Ts>>::hash(std::declval<const _Ts &>())) && ...
+)) requires (ElementHashable<_Ts> && ...) {
+  return std::apply([] (const _Ts &...elements) {
+    size_t h = 0;
+    ((h = combineHashes(h, ElementHasher<std::remove_cvref_t<_Ts>>::hash(elements))), ...);
+    return h;
+  }, o);
+}
+
+template<typename ..._Ts> size_t ElementHasher<std::tuple<_Ts...>>::hash (const std::tuple<_Ts...> &o, const HashKey &key) noexcept((
+  noexcept(ElementHasher<std::remove_cvref_t<_Ts>>::hash(std::declval<const _Ts &>(), key)) && ...
+)) requires (KeyedElementHashable<_Ts> && ...) {
+  return std::apply([&key] (const _Ts &...elements) {
+    size_t h = 0;
+    ((h = combineHashes(h, ElementHasher<std::remove_cvref_t<_Ts>>::hash(elements, key))), ...);
+    return h;
+  }, o);
+}
+
+// Contiguous integers are hashed in one go, as octets; other ranges combine the
+// hash values of their elements and then their count (so that e.g. nested
+// ranges that flatten to the same elements still hash differently).
+template<HashableRange _R> size_t ElementHasher<_R>::hash (const _R &o) noexcept(noexcept(
+  ElementHasher<Element>::hash(std::declval<const Element &>())
+)) requires ElementHashable<Element> {
+  if constexpr (std::ranges::contiguous_range<_R> && std::integral<Element>) {
+    auto i = reinterpret_cast<const iu8f *>(std::ranges::data(o));
+    return core::hash(i, i + std::ranges::size(o) * sizeof(Element));
+  } else {
+    size_t h = 0;
+    size_t count = 0;
+    for (const Element &e : o) {
+      h = combineHashes(h, ElementHasher<Element>::hash(e));
+      ++count;
+    }
+    return combineHashes(h, count);
+  }
+}
+
+template<HashableRange _R> size_t ElementHasher<_R>::hash (const _R &o, const HashKey &key) noexcept(noexcept(
+  ElementHasher<Element>::hash(std::declval<const Element &>(), key)
+)) requires KeyedElementHashable<Element> {
+  if constexpr (std::ranges::contiguous_range<_R> && std::integral<Element>) {
+    auto i = reinterpret_cast<const iu8f *>(std::ranges::data(o));
+    return core::hash(i, i + std::ranges::size(o) * sizeof(Element), key);
+  } else {
+    size_t h = 0;
+    size_t count = 0;
+    for (const Element &e : o) {
+      h = combineHashes(h, ElementHasher<Element>::hash(e, key));
+      ++count;
+    }
+    return combineHashes(h, count);
+  }
+}
+
+template<typename _T, bool _keyed> template<typename ..._Ts> requires requires (_Ts &&...ts) {
+  {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+} SlowHashWrapper<_T, _keyed>::SlowHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)) && noexcept(wrapperHashSlow<_keyed>(o))) :
+  o(std::forward<_Ts>(ts)...), h(wrapperHashSlow<_keyed>(o))
+{
+}
+
+template<typename _T, bool _keyed> template<typename ..._Ts> requires requires (_Ts &&...ts) {
+  {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+} SlowHashWrapper<_T, _keyed>::SlowHashWrapper (PrecomputedHash precomputedH, _Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...))) :
+  o(std::forward<_Ts>(ts)...), h(precomputedH.h)
+{
+}
+
+template<typename _T, bool _keyed> const _T &SlowHashWrapper<_T, _keyed>::get () const noexcept {
+  return o;
+}
+
+template<typename _T, bool _keyed> _T SlowHashWrapper<_T, _keyed>::release () && noexcept {
+  return std::move(o);
+}
+
+template<typename _T, bool _keyed> size_t SlowHashWrapper<_T, _keyed>::hashFast () const noexcept {
+  return h;
+}
+
+template<typename _T, bool _keyed> bool SlowHashWrapper<_T, _keyed>::operator== (const SlowHashWrapper<_T, _keyed> &r) const noexcept(noexcept(r.get() == r.get())) {
+  return hashFast() == r.hashFast() && get() == r.get();
+}
+
+template<typename _T, bool _keyed> template<typename ..._Ts> requires requires (_Ts &&...ts) {
+  {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+} FastHashWrapper<_T, _keyed>::FastHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...))) :
+  o(std::forward<_Ts>(ts)...)
+{
+}
+
+template<typename _T, bool _keyed> const _T &FastHashWrapper<_T, _keyed>::get () const noexcept {
+  return o;
+}
+
+template<typename _T, bool _keyed> _T FastHashWrapper<_T, _keyed>::release () && noexcept {
+  return std::move(o);
+}
+
+template<typename _T, bool _keyed> size_t FastHashWrapper<_T, _keyed>::hashFast () const noexcept {
+  using core::hashFast;
+  DSPRE(noexcept(hashFast(o)), "");
+  if constexpr (_keyed) {
+    return mixHash(hashFast(o), getProcessHashKey());
+  } else {
+    return hashFast(o);
+  }
+}
+
+template<typename _T, bool _keyed> bool FastHashWrapper<_T, _keyed>::operator== (const FastHashWrapper<_T, _keyed> &r) const noexcept(noexcept(r.get() == r.get())) {
+  return get() == r.get();
+}
+
+template<SlowHashable _T, bool _keyed> template<typename ..._Ts> requires requires (_Ts &&...ts) {
+  {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+} CompactHashWrapper<_T, _keyed>::CompactHashWrapper (_Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...)) && noexcept(wrapperHashSlow<_keyed>(o))) :
+  o(std::forward<_Ts>(ts)...), h(fold(wrapperHashSlow<_keyed>(o)))
+{
+}
+
+template<SlowHashable _T, bool _keyed> template<typename ..._Ts> requires requires (_Ts &&...ts) {
+  {_T(std::forward<_Ts>(ts)...)} -> std::same_as<_T>;
+} CompactHashWrapper<_T, _keyed>::CompactHashWrapper (PrecomputedHash precomputedH, _Ts &&...ts) noexcept(noexcept(_T(std::forward<_Ts>(ts)...))) :
+  o(std::forward<_Ts>(ts)...), h(fold(precomputedH.h))
+{
+}
+
+template<SlowHashable _T, bool _keyed> const _T &CompactHashWrapper<_T, _keyed>::get () const noexcept {
+  return o;
+}
+
+template<SlowHashable _T, bool _keyed> _T CompactHashWrapper<_T, _keyed>::release () && noexcept {
+  return std::move(o);
+}
+
+// Multiplying by an odd constant keeps the 2^32 fragments distinct and carries
+// each fragment bit into all of the higher bits (so that tables that take
+// positions from the high bits, and those that take them from the low bits,
+// both see all 32 bits vary).
+template<SlowHashable _T, bool _keyed> size_t CompactHashWrapper<_T, _keyed>::hashFast () const noexcept {
+  iu64f v = static_cast<iu64f>(h);
+  return static_cast<size_t>((v | (v << 32)) * hashing::hashPrime0);
+}
+
+template<SlowHashable _T, bool _keyed> bool CompactHashWrapper<_T, _keyed>::operator== (const CompactHashWrapper<_T, _keyed> &r) const noexcept(noexcept(r.get() == r.get())) {
+  return h == r.h && get() == r.get();
+}
+
+template<SlowHashable _T, bool _keyed> iu32f CompactHashWrapper<_T, _keyed>::fold (size_t h) noexcept {
+  auto v = static_cast<iu64f>(h);
+  return static_cast<iu32f>(v ^ (v >> 32));
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+// Tables follow the SwissTable design. The capacity is zero or one less than a
+// power of two (no smaller than a Group). The control octets are followed by a
+// sentinel (at which iteration stops) and copies of the first _G::width - 1
+// control octets (so that a Group can be loaded from any slot). Probing goes
+// from Group to Group in a triangular sequence, which visits every slot when
+// the capacity is one less than a power of two. Erased slots are marked as
+// deleted and reclaimed when the table is next rehashed.
+namespace flathash {
+
+template<typename _i, iu _sh> constexpr GroupMask<_i, _sh>::GroupMask (_i bits) noexcept : bits(bits) {
+}
+
+template<typename _i, iu _sh> GroupMask<_i, _sh>::operator bool () const noexcept {
+  return bits != 0;
+}
+
+template<typename _i, iu _sh> iu GroupMask<_i, _sh>::lowest () const noexcept {
+  return getLowestSetBit(bits) >> _sh;
+}
+
+template<typename _i, iu _sh> void GroupMask<_i, _sh>::removeLowest () noexcept {
+  bits &= bits - 1;
+}
+
+#if defined(ARCH_X86) && defined(__SSE2__)
+inline Sse2Group::Sse2Group (const is8f *ctrls) noexcept : ctrls(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ctrls))) {
+}
+
+inline Sse2Group::Mask Sse2Group::match (is8f h2) const noexcept {
+  return Mask(static_cast<iu32f>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrls))));
+}
+
+inline Sse2Group::Mask Sse2Group::matchEmpty () const noexcept {
+  return Mask(static_cast<iu32f>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(ctrlEmpty), ctrls))));
+}
+
+inline Sse2Group::Mask Sse2Group::matchEmptyOrDeleted () const noexcept {
+  return Mask(static_cast<iu32f>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(ctrlSentinel), ctrls))));
+}
+#endif
+
+// Each control octet is examined via the corresponding octet of a word, with
+// the result in its top bit. match() can give false positives (only above a
+// real match), which are rejected by the comparison of the keys.
+inline WordGroup::WordGroup (const is8f *ctrls) noexcept : ctrls(hashing::read64(ctrls)) {
+}
+
+inline WordGroup::Mask WordGroup::match (is8f h2) const noexcept {
+  const iu64f lsbs = 0x0101010101010101ULL;
+  iu64f x = ctrls ^ (lsbs * static_cast<iu8f>(h2));
+  return Mask((x - lsbs) & ~x & (lsbs << 7));
+}
+
+inline WordGroup::Mask WordGroup::matchEmpty () const noexcept {
+  return Mask(ctrls & ~(ctrls << 6) & 0x8080808080808080ULL);
+}
+
+inline WordGroup::Mask WordGroup::matchEmptyOrDeleted () const noexcept {
+  return Mask(ctrls & ~(ctrls << 7) & 0x8080808080808080ULL);
+}
+
+// The control octets of tables with no capacity, which are never written to.
+alignas(16) inline is8f emptyCtrls[16] = {
+  ctrlSentinel, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty,
+  ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty, ctrlEmpty
+};
+
+template<typename _E> Iterator<_E>::Iterator () noexcept : ctrl(nullptr), slot(nullptr) {
+}
+
+template<typename _E> Iterator<_E>::Iterator (const is8f *ctrl, _E *slot) noexcept : ctrl(ctrl), slot(slot) {
+  while (*this->ctrl < ctrlSentinel) {
+    ++this->ctrl;
+    ++this->slot;
+  }
+}
+
+template<typename _E> template<typename _E2> requires std::same_as<const _E2, _E> Iterator<_E>::Iterator (const Iterator<_E2> &o) noexcept : ctrl(o.ctrl), slot(o.slot) {
+}
+
+template<typename _E> _E &Iterator<_E>::operator* () const noexcept {
+  DPRE(*ctrl >= 0, "the iterator must be at an element");
+  return *slot;
+}
+
+template<typename _E> _E *Iterator<_E>::operator-> () const noexcept {
+  DPRE(*ctrl >= 0, "the iterator must be at an element");
+  return slot;
+}
+
+template<typename _E> Iterator<_E> &Iterator<_E>::operator++ () noexcept {
+  DPRE(*ctrl >= 0, "the iterator must be at an element");
+  *this = Iterator<_E>(ctrl + 1, slot + 1);
+  return *this;
+}
+
+template<typename _E> Iterator<_E> Iterator<_E>::operator++ (int) noexcept {
+  Iterator<_E> i = *this;
+  ++*this;
+  return i;
+}
+
+template<typename _E> bool Iterator<_E>::operator== (const Iterator<_E> &r) const noexcept {
+  return slot == r.slot && ctrl == r.ctrl;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> Table<_K, _E, _mutableElements, _G>::Table () noexcept :
+  ctrls(emptyCtrls), slots(nullptr), capacity(0), elementCount(0), growthLeft(0)
+{
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> Table<_K, _E, _mutableElements, _G>::Table (const Table<_K, _E, _mutableElements, _G> &o) : Table() {
+  reserve(o.elementCount);
+  try {
+    for (const _E &e : o) {
+      iu64f m = mixHash(hashFast(getKey(e)));
+      size_t index = findNonFullIndex(m);
+      new (slots + index) _E(e);
+      setCtrl(index, static_cast<is8f>(m & 0x7F));
+      ++elementCount;
+      --growthLeft;
+    }
+  } catch (...) {
+    destroy();
+    throw;
+  }
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> Table<_K, _E, _mutableElements, _G>::Table (Table<_K, _E, _mutableElements, _G> &&o) noexcept :
+  ctrls(o.ctrls), slots(o.slots), capacity(o.capacity), elementCount(o.elementCount), growthLeft(o.growthLeft)
+{
+  o.ctrls = emptyCtrls;
+  o.slots = nullptr;
+  o.capacity = 0;
+  o.elementCount = 0;
+  o.growthLeft = 0;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> Table<_K, _E, _mutableElements, _G> &Table<_K, _E, _mutableElements, _G>::operator= (const Table<_K, _E, _mutableElements, _G> &o) {
+  if (this != &o) {
+    *this = Table<_K, _E, _mutableElements, _G>(o);
+  }
+  return *this;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> Table<_K, _E, _mutableElements, _G> &Table<_K, _E, _mutableElements, _G>::operator= (Table<_K, _E, _mutableElements, _G> &&o) noexcept {
+  if (this != &o) {
+    destroy();
+    ctrls = o.ctrls;
+    slots = o.slots;
+    capacity = o.capacity;
+    elementCount = o.elementCount;
+    growthLeft = o.growthLeft;
+    o.ctrls = emptyCtrls;
+    o.slots = nullptr;
+    o.capacity = 0;
+    o.elementCount = 0;
+    o.growthLeft = 0;
+  }
+  return *this;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> Table<_K, _E, _mutableElements, _G>::~Table () noexcept {
+  destroy();
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> size_t Table<_K, _E, _mutableElements, _G>::size () const noexcept {
+  return elementCount;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> bool Table<_K, _E, _mutableElements, _G>::empty () const noexcept {
+  return elementCount == 0;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> void Table<_K, _E, _mutableElements, _G>::clear () noexcept {
+  if (capacity == 0) {
+    return;
+  }
+
+  for (size_t i = 0; i != capacity; ++i) {
+    if (ctrls[i] >= 0) {
+      slots[i].~_E();
+    }
+  }
+  memset(ctrls, ctrlEmpty, getCtrlsSize(capacity));
+  ctrls[capacity] = ctrlSentinel;
+  elementCount = 0;
+  growthLeft = getGrowth(capacity);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> void Table<_K, _E, _mutableElements, _G>::reserve (size_t count) {
+  if (count <= elementCount + growthLeft) {
+    return;
+  }
+
+  size_t newCapacity = _G::width - 1;
+  while (getGrowth(newCapacity) < count) {
+    newCapacity = newCapacity * 2 + 1;
+  }
+  rehash(newCapacity);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::iterator Table<_K, _E, _mutableElements, _G>::begin () noexcept {
+  return iterator(ctrls, slots);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::const_iterator Table<_K, _E, _mutableElements, _G>::begin () const noexcept {
+  return const_iterator(ctrls, slots);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::iterator Table<_K, _E, _mutableElements, _G>::end () noexcept {
+  return iterator(ctrls + capacity, slots + capacity);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::const_iterator Table<_K, _E, _mutableElements, _G>::end () const noexcept {
+  return const_iterator(ctrls + capacity, slots + capacity);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::iterator Table<_K, _E, _mutableElements, _G>::find (const _K &key) noexcept(noexcept(key == key)) {
+  return at(findIndex(key, mixHash(hashFast(key))));
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::const_iterator Table<_K, _E, _mutableElements, _G>::find (const _K &key) const noexcept(noexcept(key == key)) {
+  size_t index = findIndex(key, mixHash(hashFast(key)));
+  return const_iterator(ctrls + index, slots + index);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> template<typename _Q> requires LookupKey<_Q, _K> typename Table<_K, _E, _mutableElements, _G>::iterator Table<_K, _E, _mutableElements, _G>::find (const _Q &key) noexcept(noexcept(key == std::declval<const _K &>())) {
+  return at(findIndex(key, mixHash(hashFast(key))));
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> template<typename _Q> requires LookupKey<_Q, _K> typename Table<_K, _E, _mutableElements, _G>::const_iterator Table<_K, _E, _mutableElements, _G>::find (const _Q &key) const noexcept(noexcept(key == std::declval<const _K &>())) {
+  size_t index = findIndex(key, mixHash(hashFast(key)));
+  return const_iterator(ctrls + index, slots + index);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> bool Table<_K, _E, _mutableElements, _G>::contains (const _K &key) const noexcept(noexcept(key == key)) {
+  return findIndex(key, mixHash(hashFast(key))) != capacity;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> template<typename _Q> requires LookupKey<_Q, _K> bool Table<_K, _E, _mutableElements, _G>::contains (const _Q &key) const noexcept(noexcept(key == std::declval<const _K &>())) {
+  return findIndex(key, mixHash(hashFast(key))) != capacity;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> size_t Table<_K, _E, _mutableElements, _G>::erase (const _K &key) noexcept(noexcept(key == key)) {
+  size_t index = findIndex(key, mixHash(hashFast(key)));
+  if (index == capacity) {
+    return 0;
+  }
+
+  erase(const_iterator(ctrls + index, slots + index));
+  return 1;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> template<typename _Q> requires LookupKey<_Q, _K> size_t Table<_K, _E, _mutableElements, _G>::erase (const _Q &key) noexcept(noexcept(key == std::declval<const _K &>())) {
+  size_t index = findIndex(key, mixHash(hashFast(key)));
+  if (index == capacity) {
+    return 0;
+  }
+
+  erase(const_iterator(ctrls + index, slots + index));
+  return 1;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::iterator Table<_K, _E, _mutableElements, _G>::erase (const_iterator i) noexcept {
+  size_t index = offset(static_cast<const _E *>(slots), i.slot);
+  DPRE(index < capacity && ctrls[index] >= 0, "the iterator must be at an element");
+
+  slots[index].~_E();
+  setCtrl(index, ctrlDeleted);
+  --elementCount;
+  return iterator(ctrls + index + 1, slots + index + 1);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> const _K &Table<_K, _E, _mutableElements, _G>::getKey (const _E &e) noexcept {
+  if constexpr (std::same_as<_K, _E>) {
+    return e;
+  } else {
+    return e.getKey();
+  }
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> size_t Table<_K, _E, _mutableElements, _G>::getCtrlsSize (size_t capacity) noexcept {
+  return capacity + _G::width;
+}
+
+// Keep at least one slot (and about an eighth of them) empty, so that probing
+// always ends.
+template<typename _K, typename _E, bool _mutableElements, typename _G> size_t Table<_K, _E, _mutableElements, _G>::getGrowth (size_t capacity) noexcept {
+  return capacity - std::max(static_cast<size_t>(1), capacity / 8);
+}
+
+// The table takes the position to probe from the high bits and the control
+// octet from the low 7 bits, so the hash value is mixed (cheaply) to make sure
+// that both are well distributed even for simple FastHashable types.
+template<typename _K, typename _E, bool _mutableElements, typename _G> iu64f Table<_K, _E, _mutableElements, _G>::mixHash (size_t h) noexcept {
+  return hashing::mum(static_cast<iu64f>(h), hashing::hashPrime0);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> template<typename _Q> size_t Table<_K, _E, _mutableElements, _G>::findIndex (const _Q &key, iu64f m) const noexcept(noexcept(key == std::declval<const _K &>())) {
+  auto h2 = static_cast<is8f>(m & 0x7F);
+  size_t pos = static_cast<size_t>(m >> 7) & capacity;
+  for (size_t step = _G::width;; step += _G::width) {
+    _G g(ctrls + pos);
+    for (auto matches = g.match(h2); matches; matches.removeLowest()) {
+      size_t index = (pos + matches.lowest()) & capacity;
+      if (getKey(slots[index]) == key) {
+        return index;
+      }
+    }
+    if (g.matchEmpty()) {
+      return capacity;
+    }
+    DA(step <= capacity, "the table must have an empty slot");
+    pos = (pos + step) & capacity;
+  }
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> size_t Table<_K, _E, _mutableElements, _G>::findNonFullIndex (iu64f m) const noexcept {
+  size_t pos = static_cast<size_t>(m >> 7) & capacity;
+  for (size_t step = _G::width;; step += _G::width) {
+    auto matches = _G(ctrls + pos).matchEmptyOrDeleted();
+    if (matches) {
+      return (pos + matches.lowest()) & capacity;
+    }
+    DA(step <= capacity, "the table must have an empty slot");
+    pos = (pos + step) & capacity;
+  }
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> void Table<_K, _E, _mutableElements, _G>::setCtrl (size_t index, is8f ctrl) noexcept {
+  ctrls[index] = ctrl;
+  ctrls[((index - (_G::width - 1)) & capacity) + (_G::width - 1)] = ctrl;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> void Table<_K, _E, _mutableElements, _G>::rehash (size_t newCapacity) {
+  DSA(std::is_nothrow_move_constructible<_E>::value, "elements must be movable without throwing");
+  DPRE(newCapacity >= _G::width - 1 && ((newCapacity + 1) & newCapacity) == 0, "newCapacity must be one less than a power of two");
+  DPRE(getGrowth(newCapacity) >= elementCount);
+
+  size_t slotsOffset = (getCtrlsSize(newCapacity) + alignof(_E) - 1) / alignof(_E) * alignof(_E);
+  auto block = static_cast<iu8f *>(::operator new(slotsOffset + newCapacity * sizeof(_E), std::align_val_t(alignof(_E))));
+  is8f *oldCtrls = ctrls;
+  _E *oldSlots = slots;
+  size_t oldCapacity = capacity;
+  ctrls = reinterpret_cast<is8f *>(block);
+  slots = reinterpret_cast<_E *>(block + slotsOffset);
+  capacity = newCapacity;
+  memset(ctrls, ctrlEmpty, getCtrlsSize(capacity));
+  ctrls[capacity] = ctrlSentinel;
+  growthLeft = getGrowth(capacity) - elementCount;
+
+  // The hash values come from hashFast() (which, for a HashWrapper, is just
+  // the stored value).
+  for (size_t i = 0; i != oldCapacity; ++i) {
+    if (oldCtrls[i] >= 0) {
+      iu64f m = mixHash(hashFast(getKey(oldSlots[i])));
+      size_t index = findNonFullIndex(m);
+      new (slots + index) _E(std::move(oldSlots[i]));
+      oldSlots[i].~_E();
+      setCtrl(index, static_cast<is8f>(m & 0x7F));
+    }
+  }
+
+  if (oldCapacity != 0) {
+    ::operator delete(oldCtrls, std::align_val_t(alignof(_E)));
+  }
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> void Table<_K, _E, _mutableElements, _G>::destroy () noexcept {
+  if (capacity == 0) {
+    return;
+  }
+
+  for (size_t i = 0; i != capacity; ++i) {
+    if (ctrls[i] >= 0) {
+      slots[i].~_E();
+    }
+  }
+  ::operator delete(ctrls, std::align_val_t(alignof(_E)));
+  ctrls = emptyCtrls;
+  slots = nullptr;
+  capacity = 0;
+  elementCount = 0;
+  growthLeft = 0;
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> template<typename _F> std::pair<size_t, bool> Table<_K, _E, _mutableElements, _G>::findOrInsert (const _K &key, _F &&construct) {
+  iu64f m = mixHash(hashFast(key));
+  size_t index = findIndex(key, m);
+  if (index != capacity) {
+    return std::pair<size_t, bool>(index, false);
+  }
+
+  if (growthLeft == 0) {
+    // Reclaim deleted slots if they make up much of the table; otherwise, grow.
+    rehash(capacity == 0 ? _G::width - 1 : elementCount * 32 <= capacity * 25 ? capacity : capacity * 2 + 1);
+  }
+  index = findNonFullIndex(m);
+  construct(slots + index);
+  growthLeft -= (ctrls[index] == ctrlEmpty);
+  setCtrl(index, static_cast<is8f>(m & 0x7F));
+  ++elementCount;
+  return std::pair<size_t, bool>(index, true);
+}
+
+template<typename _K, typename _E, bool _mutableElements, typename _G> typename Table<_K, _E, _mutableElements, _G>::iterator Table<_K, _E, _mutableElements, _G>::at (size_t index) noexcept {
+  return iterator(ctrls + index, slots + index);
+}
+
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<typename _K, typename _G> requires FastHashable<_K> std::pair<typename FlatHashSet<_K, _G>::iterator, bool> FlatHashSet<_K, _G>::insert (const _K &o) {
+  auto r = this->findOrInsert(o, [&] (_K *slot) {
+    new (slot) _K(o);
+  });
+  return std::pair<iterator, bool>(this->at(r.first), r.second);
+}
+
+template<typename _K, typename _G> requires FastHashable<_K> std::pair<typename FlatHashSet<_K, _G>::iterator, bool> FlatHashSet<_K, _G>::insert (_K &&o) {
+  auto r = this->findOrInsert(o, [&] (_K *slot) {
+    new (slot) _K(std::move(o));
+  });
+  return std::pair<iterator, bool>(this->at(r.first), r.second);
+}
+
+template<typename _K, typename _G> requires FastHashable<_K> template<typename ..._Ts> std::pair<typename FlatHashSet<_K, _G>::iterator, bool> FlatHashSet<_K, _G>::emplace (_Ts &&...ts) {
+  return insert(_K(std::forward<_Ts>(ts)...));
+}
+
+template<typename _K, typename _V> template<typename _KArg, typename ..._Ts> FlatHashMapEntry<_K, _V>::FlatHashMapEntry (_KArg &&k, _Ts &&...ts) :
+  key(std::forward<_KArg>(k)), value(std::forward<_Ts>(ts)...)
+{
+}
+
+template<typename _K, typename _V> const _K &FlatHashMapEntry<_K, _V>::getKey () const noexcept {
+  return key;
+}
+
+template<typename _K, typename _V> _V &FlatHashMapEntry<_K, _V>::getValue () noexcept {
+  return value;
+}
+
+template<typename _K, typename _V> const _V &FlatHashMapEntry<_K, _V>::getValue () const noexcept {
+  return value;
+}
+
+template<typename _K, typename _V, typename _G> requires FastHashable<_K> template<typename ..._Ts> std::pair<typename FlatHashMap<_K, _V, _G>::iterator, bool> FlatHashMap<_K, _V, _G>::try_emplace (const _K &key, _Ts &&...ts) {
+  auto r = this->findOrInsert(key, [&] (FlatHashMapEntry<_K, _V> *slot) {
+    new (slot) FlatHashMapEntry<_K, _V>(key, std::forward<_Ts>(ts)...);
+  });
+  return std::pair<iterator, bool>(this->at(r.first), r.second);
+}
+
+template<typename _K, typename _V, typename _G> requires FastHashable<_K> template<typename ..._Ts> std::pair<typename FlatHashMap<_K, _V, _G>::iterator, bool> FlatHashMap<_K, _V, _G>::try_emplace (_K &&key, _Ts &&...ts) {
+  auto r = this->findOrInsert(key, [&] (FlatHashMapEntry<_K, _V> *slot) {
+    new (slot) FlatHashMapEntry<_K, _V>(std::move(key), std::forward<_Ts>(ts)...);
+  });
+  return std::pair<iterator, bool>(this->at(r.first), r.second);
+}
+
+template<typename _K, typename _V, typename _G> requires FastHashable<_K> _V &FlatHashMap<_K, _V, _G>::operator[] (const _K &key) {
+  return try_emplace(key).first->getValue();
+}
+
+template<typename _K, typename _V, typename _G> requires FastHashable<_K> _V &FlatHashMap<_K, _V, _G>::operator[] (_K &&key) {
+  return try_emplace(std::move(key)).first->getValue();
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> ConcurrentHashMap<_K, _V>::ConcurrentHashMap (size_t shardCount) {
+  DPRE(shardCount != 0);
+
+  size_t count = 1;
+  while (count < shardCount) {
+    count *= 2;
+  }
+  shards.reset(new Shard[count]);
+  shardMask = count - 1;
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> size_t ConcurrentHashMap<_K, _V>::size () const {
+  size_t count = 0;
+  for (size_t i = 0; i <= shardMask; ++i) {
+    std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+    count += shards[i].map.size();
+  }
+  return count;
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> void ConcurrentHashMap<_K, _V>::clear () {
+  for (size_t i = 0; i <= shardMask; ++i) {
+    std::unique_lock<std::shared_mutex> lock(shards[i].mutex);
+    shards[i].map.clear();
+  }
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> bool ConcurrentHashMap<_K, _V>::contains (const _K &key) const {
+  return containsImpl(key);
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _Q> requires flathash::LookupKey<_Q, _K> bool ConcurrentHashMap<_K, _V>::contains (const _Q &key) const {
+  return containsImpl(key);
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> std::optional<_V> ConcurrentHashMap<_K, _V>::get (const _K &key) const {
+  return getImpl(key);
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _Q> requires flathash::LookupKey<_Q, _K> std::optional<_V> ConcurrentHashMap<_K, _V>::get (const _Q &key) const {
+  return getImpl(key);
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _F> bool ConcurrentHashMap<_K, _V>::visit (const _K &key, _F &&visitor) const {
+  return visitImpl(key, std::forward<_F>(visitor));
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _Q, typename _F> requires flathash::LookupKey<_Q, _K> bool ConcurrentHashMap<_K, _V>::visit (const _Q &key, _F &&visitor) const {
+  return visitImpl(key, std::forward<_F>(visitor));
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _Q> bool ConcurrentHashMap<_K, _V>::containsImpl (const _Q &key) const {
+  Shard &shard = getShard(key);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  return shard.map.contains(key);
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _Q> std::optional<_V> ConcurrentHashMap<_K, _V>::getImpl (const _Q &key) const {
+  Shard &shard = getShard(key);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  auto i = shard.map.find(key);
+  if (i == shard.map.end()) {
+    return std::nullopt;
+  }
+  return std::optional<_V>(i->getValue());
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _Q, typename _F> bool ConcurrentHashMap<_K, _V>::visitImpl (const _Q &key, _F &&visitor) const {
+  const Shard &shard = getShard(key);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  auto i = shard.map.find(key);
+  if (i == shard.map.end()) {
+    return false;
+  }
+  visitor(static_cast<const _V &>(i->getValue()));
+  return true;
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _F> void ConcurrentHashMap<_K, _V>::forEach (_F &&visitor) const {
+  for (size_t i = 0; i <= shardMask; ++i) {
+    const Shard &shard = shards[i];
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    for (const FlatHashMapEntry<_K, _V> &e : shard.map) {
+      visitor(e.getKey(), e.getValue());
+    }
+  }
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename ..._Ts> bool ConcurrentHashMap<_K, _V>::try_emplace (const _K &key, _Ts &&...ts) {
+  Shard &shard = getShard(key);
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  return shard.map.try_emplace(key, std::forward<_Ts>(ts)...).second;
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _VArg> bool ConcurrentHashMap<_K, _V>::insert_or_assign (const _K &key, _VArg &&value) {
+  Shard &shard = getShard(key);
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  auto r = shard.map.try_emplace(key, std::forward<_VArg>(value));
+  if (!r.second) {
+    r.first->getValue() = std::forward<_VArg>(value);
+  }
+  return r.second;
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _F> void ConcurrentHashMap<_K, _V>::update (const _K &key, _F &&updater) {
+  Shard &shard = getShard(key);
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  updater(shard.map[key]);
+}
+
+template<typename _K, typename _V> requires FastHashable<_K> bool ConcurrentHashMap<_K, _V>::erase (const _K &key) {
+  Shard &shard = getShard(key);
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  return shard.map.erase(key) != 0;
+}
+
+// The shard is picked by a different mix of the hash value to that which the
+// shard's table uses for the position, so that each table is filled evenly.
+template<typename _K, typename _V> requires FastHashable<_K> template<typename _Q> typename ConcurrentHashMap<_K, _V>::Shard &ConcurrentHashMap<_K, _V>::getShard (const _Q &key) const noexcept {
+  return shards[static_cast<size_t>(hashing::mum(static_cast<iu64f>(hashFast(key)), hashing::hashPrime1)) & shardMask];
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<FastHashable _K> void BloomFilter::insert (const _K &key) noexcept {
+  insertHash(hashFast(key));
+}
+
+template<FastHashable _K> bool BloomFilter::mayContain (const _K &key) const noexcept {
+  return mayContainHash(hashFast(key));
+}
+
+template<core::OutputIterator<iu8f> _OutputIterator> void BloomFilter::write (_OutputIterator &r_ptr) const {
+  writeIeu(r_ptr, formatVersion);
+  writeIeu(r_ptr, blockCount);
+  for (size_t i = 0; i != blockCount; ++i) {
+    for (iu32f word : blocks[i].words) {
+      for (iu j = 0; j != 4; ++j) {
+        *(r_ptr++) = static_cast<iu8f>(word >> (j * 8));
+      }
+    }
+  }
+}
+
+template<core::InputIterator<iu8f> _InputIterator, typename _InputEndIterator> BloomFilter BloomFilter::read (_InputIterator &r_ptr, const _InputEndIterator &ptrEnd) {
+  if (readIeu<iu>(r_ptr, ptrEnd) != formatVersion) {
+    throw PlainException(u8"Bloom filter was of an unsupported format");
+  }
+  auto writtenCount = readIeu<iu64f>(r_ptr, ptrEnd);
+  if (writtenCount == 0 || writtenCount > maxBlockCount) {
+    throw PlainException(u8"Bloom filter had an invalid number of blocks");
+  }
+  auto count = static_cast<size_t>(writtenCount);
+
+  // The block count isn't trusted to size the filter up front: where the
+  // stream's length is known, it must hold all of the blocks; otherwise the
+  // blocks are allocated in doubling pieces as they are read.
+  size_t allocatedCount = count;
+  if constexpr (std::sized_sentinel_for<_InputEndIterator, _InputIterator>) {
+    if (count > static_cast<size_t>(ptrEnd - r_ptr) / sizeof(Block)) {
+      throw PlainException(u8"Bloom filter was truncated");
+    }
+  } else {
+    allocatedCount = std::min(count, readingBlockCount);
+  }
+
+  BloomFilter filter(allocatedCount);
+  for (size_t i = 0; i != count; ++i) {
+    if (i == allocatedCount) {
+      allocatedCount = std::min(count, allocatedCount * 2);
+      std::unique_ptr<Block[]> blocks(new Block[allocatedCount]());
+      std::copy(filter.blocks.get(), filter.blocks.get() + i, blocks.get());
+      filter.blocks = std::move(blocks);
+      filter.blockCount = allocatedCount;
+    }
+    for (iu32f &word : filter.blocks[i].words) {
+      for (iu j = 0; j != 4; ++j) {
+        if (r_ptr == ptrEnd) {
+          throw PlainException(u8"Bloom filter was truncated");
+        }
+        word |= static_cast<iu32f>(*(r_ptr++)) << (j * 8);
+      }
+    }
+  }
+  return filter;
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<typename _Octets> void appendIeu (_Octets &r_octets, size_t value) {
+  size_t oldSize = r_octets.size();
+  r_octets.resize(oldSize + getIeuSize(value));
+  iu8f *ptr = r_octets.data() + oldSize;
+  writeIeu(ptr, value);
+}
+
+template<typename _Octets, std::integral _i> requires requires (_Octets &r_octets, size_t size) {
+  r_octets.resize(size);
+  {r_octets.data()} -> std::same_as<iu8f *>;
+} void writeDeltaSequence (_Octets &r_octets, const _i *in, size_t count) {
+  typedef typename std::make_unsigned<_i>::type U;
+  constexpr size_t blockSize = DeltaSequenceReader<_i>::blockSize;
+
+  core::appendIeu(r_octets, count);
+  U values[blockSize];
+  for (size_t i = 0; i != count;) {
+    size_t blockCount = std::min(blockSize, count - i);
+    values[0] = static_cast<U>(in[i]);
+    if (std::is_signed<_i>::value) {
+      values[0] = encodeZigzag(values[0]);
+    }
+    for (size_t j = 1; j != blockCount; ++j) {
+      values[j] = encodeZigzag(static_cast<U>(static_cast<U>(in[i + j]) - static_cast<U>(in[i + j - 1])));
+    }
+    core::appendIeu(r_octets, getIeuArraySize(values, blockCount));
+    writeIeuArray(r_octets, values, blockCount);
+    i += blockCount;
+  }
+}
+
+template<std::unsigned_integral _i> void addZigzagDeltasScalar (_i *values, size_t count) noexcept {
+  for (size_t i = 1; i < count; ++i) {
+    values[i] = static_cast<_i>(values[i - 1] + decodeZigzag(values[i]));
+  }
+}
+
+template<std::integral _i> DeltaSequenceReader<_i>::DeltaSequenceReader (const iu8f *ptr, const iu8f *ptrEnd) :
+  ptr(ptr), ptrEnd(ptrEnd), count(0), index(0)
+{
+  count = readIeu<size_t>(this->ptr, ptrEnd);
+}
+
+template<std::integral _i> size_t DeltaSequenceReader<_i>::size () const noexcept {
+  return count;
+}
+
+template<std::integral _i> size_t DeltaSequenceReader<_i>::getIndex () const noexcept {
+  return index;
+}
+
+template<std::integral _i> const iu8f *DeltaSequenceReader<_i>::getPtr () const noexcept {
+  return ptr;
+}
+
+// The values are decoded in place, as their unsigned equivalents (which may
+// alias them).
+template<std::integral _i> size_t DeltaSequenceReader<_i>::readBlock (_i *out) {
+  typedef typename std::make_unsigned<_i>::type U;
+  size_t blockCount = getBlockCount();
+  if (blockCount == 0) {
+    return 0;
+  }
+
+  auto size = readIeu<size_t>(ptr, ptrEnd);
+  if (size > offset(ptr, ptrEnd)) {
+    throw PlainException(u8"delta sequence was truncated");
+  }
+  const iu8f *blockEnd = ptr + size;
+  U *values = reinterpret_cast<U *>(out);
+  readIeuArray(ptr, blockEnd, values, blockCount);
+  if (ptr != blockEnd) {
+    throw PlainException(u8"delta sequence block had the wrong size");
+  }
+  if (std::is_signed<_i>::value) {
+    values[0] = decodeZigzag(values[0]);
+  }
+  if constexpr (std::same_as<U, iu32f> || std::same_as<U, iu64f>) {
+    addZigzagDeltas(values, blockCount);
+  } else {
+    addZigzagDeltasScalar(values, blockCount);
+  }
+  index += blockCount;
+  return blockCount;
+}
+
+template<std::integral _i> void DeltaSequenceReader<_i>::readAll (_i *out) {
+  while (size_t blockCount = readBlock(out)) {
+    out += blockCount;
+  }
+}
+
+template<std::integral _i> bool DeltaSequenceReader<_i>::skipBlock () {
+  size_t blockCount = getBlockCount();
+  if (blockCount == 0) {
+    return false;
+  }
+
+  auto size = readIeu<size_t>(ptr, ptrEnd);
+  if (size > offset(ptr, ptrEnd)) {
+    throw PlainException(u8"delta sequence was truncated");
+  }
+  ptr += size;
+  index += blockCount;
+  return true;
+}
+
+template<std::integral _i> void DeltaSequenceReader<_i>::skipToIndex (size_t index) {
+  while (this->index + blockSize <= index && skipBlock()) {
+  }
+}
+
+template<std::integral _i> void DeltaSequenceReader<_i>::skipToValue (_i value) {
+  while (index + blockSize < count) {
+    const iu8f *nextPtr = ptr;
+    auto size = readIeu<size_t>(nextPtr, ptrEnd);
+    if (size > offset(nextPtr, ptrEnd)) {
+      throw PlainException(u8"delta sequence was truncated");
+    }
+    nextPtr += size;
+    if (!(readFirstValue(nextPtr, ptrEnd) < value)) {
+      break;
+    }
+    ptr = nextPtr;
+    index += blockSize;
+  }
+}
+
+template<std::integral _i> size_t DeltaSequenceReader<_i>::getBlockCount () const noexcept {
+  return std::min(blockSize, count - index);
+}
+
+template<std::integral _i> _i DeltaSequenceReader<_i>::readFirstValue (const iu8f *ptr, const iu8f *ptrEnd) {
+  typedef typename std::make_unsigned<_i>::type U;
+  readIeu<size_t>(ptr, ptrEnd);
+  auto value = readIeu<U>(ptr, ptrEnd);
+  return static_cast<_i>(std::is_signed<_i>::value ? decodeZigzag(value) : value);
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+inline const iu8f *OctetSource::getPtr () const noexcept {
+  return ptr;
+}
+
+inline const iu8f *OctetSource::getEnd () const noexcept {
+  return end;
+}
+
+inline void OctetSource::setPtr (const iu8f *ptr) noexcept {
+  DPRE(this->ptr <= ptr && ptr <= end, "ptr must be within the window");
+  this->ptr = ptr;
+}
+
+inline bool OctetSource::require (size_t size) {
+  DPRE(size <= capacity, "size must be no more than the capacity");
+  while (offset(ptr, end) < size) {
+    if (!refill()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+inline iu8f *OctetSink::getPtr () const noexcept {
+  return ptr;
+}
+
+inline iu8f *OctetSink::getEnd () const noexcept {
+  return buffer.get() + capacity;
+}
+
+inline void OctetSink::setPtr (iu8f *ptr) noexcept {
+  DPRE(this->ptr <= ptr && ptr <= getEnd(), "ptr must be within the window");
+  this->ptr = ptr;
+}
+
+inline void OctetSink::require (size_t size) {
+  DPRE(size <= capacity, "size must be no more than the capacity");
+  if (offset(ptr, getEnd()) < size) {
+    flush();
+  }
+}
+
+// The window is only refilled when it might not hold the whole value. When it
+// then does, the value is read without checking for the end of the window;
+// otherwise the stream has ended, and the value is read by the pointer overload
+// (which checks against the end of the window, so that a value truncated by
+// the end of the stream is still noticed).
+template<std::unsigned_integral _i> _i readIeu (OctetSource &r_source) {
+  constexpr auto maxSize = static_cast<size_t>(numeric_limits<_i>::max_ie_octets);
+  if (offset(r_source.getPtr(), r_source.getEnd()) < maxSize) {
+    r_source.require(maxSize);
+  }
+  const iu8f *ptr = r_source.getPtr();
+  if (offset(ptr, r_source.getEnd()) >= maxSize) {
+    _i value = std::get<0>(core::readIexWithin<_i, false>(ptr, r_source.getEnd()));
+    r_source.setPtr(ptr);
+    return value;
+  }
+  finally([&] () {
+    r_source.setPtr(ptr);
+  });
+  return readIeu<_i>(ptr, r_source.getEnd());
+}
+
+template<std::signed_integral _i> _i readIes (OctetSource &r_source) {
+  constexpr auto maxSize = static_cast<size_t>(numeric_limits<_i>::max_ie_octets);
+  if (offset(r_source.getPtr(), r_source.getEnd()) < maxSize) {
+    r_source.require(maxSize);
+  }
+  const iu8f *ptr = r_source.getPtr();
+  if (offset(ptr, r_source.getEnd()) >= maxSize) {
+    typedef typename std::make_unsigned<_i>::type U;
+    static_assert(numeric_limits<U>::max_ie_octets == numeric_limits<_i>::max_ie_octets);
+    U mag;
+    bool isNegative;
+    std::tie(mag, isNegative) = core::readIexWithin<U, true>(ptr, r_source.getEnd());
+    r_source.setPtr(ptr);
+    return core::getIesValue<_i, true>(mag, isNegative);
+  }
+  finally([&] () {
+    r_source.setPtr(ptr);
+  });
+  return readIes<_i>(ptr, r_source.getEnd());
+}
+
+template<std::unsigned_integral _i> void writeIeu (OctetSink &r_sink, _i value) {
+  r_sink.require(numeric_limits<_i>::max_ie_octets);
+  iu8f *ptr = r_sink.getPtr();
+  writeIeu(ptr, value);
+  r_sink.setPtr(ptr);
+}
+
+template<std::signed_integral _i> void writeIes (OctetSink &r_sink, _i value) {
+  r_sink.require(numeric_limits<_i>::max_ie_octets);
+  iu8f *ptr = r_sink.getPtr();
+  writeIes(ptr, value);
+  r_sink.setPtr(ptr);
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+#ifdef OS_POSIX
+inline const iu8f *MappedFile::begin () const noexcept {
+  return ptr;
+}
+
+inline const iu8f *MappedFile::end () const noexcept {
+  return ptr + size;
+}
+
+inline size_t MappedFile::getSize () const noexcept {
+  return size;
+}
+#endif
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<typename _c> template<typename ..._Ts> string<_c>::string (_Ts &&...ts) :
+  std::basic_string<_c>(std::forward<_Ts>(ts)...)
+{
+}
+
+template<typename _c> string<_c>::string (typename string<_c>::size_type capacity) {
+  this->reserve(capacity);
+}
+
+template<typename _c> string<_c>::string (const string<_c> &o) : string<_c>(o.size()) {
+  this->append(o);
+}
+
+template<typename _c> string<_c>::string (string<_c> &o) : string<_c>(static_cast<const string<_c> &>(o)) {
+}
+
+template<typename _c> typename string<_c>::reference string<_c>::operator[] (typename string<_c>::size_type pos) {
+  DPRE(pos < this->size());
+  return std::basic_string<_c>::operator[](pos);
+}
+
+template<typename _c> typename string<_c>::const_reference string<_c>::operator[] (typename string<_c>::size_type pos) const {
+  DPRE(pos < this->size());
+  return std::basic_string<_c>::operator[](pos);
+}
+
+template<typename _c> _c *string<_c>::data () {
+  return &std::basic_string<_c>::operator[](0);
+}
+
+template<typename _c> void string<_c>::append_any (typename string<_c>::size_type count) {
+  this->append(count, static_cast<_c>(0x58));
+}
+
+template<typename _c> void string<_c>::resize_any (typename string<_c>::size_type count) {
+  this->resize(count, static_cast<_c>(0x58));
+}
+
+template<typename _c> size_t string<_c>::hashSlow () const noexcept {
+  const _c *begin = this->data();
+  const _c *end = begin + this->size();
+  return hash(reinterpret_cast<const iu8f *>(begin), reinterpret_cast<const iu8f *>(end));
+}
+
+template<typename _c> size_t string<_c>::hashSlow (const HashKey &key) const noexcept {
+  const _c *begin = this->data();
+  const _c *end = begin + this->size();
+  return hash(reinterpret_cast<const iu8f *>(begin), reinterpret_cast<const iu8f *>(end), key);
+}
+
+template<typename _c> void string<_c>::hashSlow (Hasher &r_hasher) const noexcept {
+  const _c *begin = this->data();
+  const _c *end = begin + this->size();
+  r_hasher.update(reinterpret_cast<const iu8f *>(begin), reinterpret_cast<const iu8f *>(end));
+  r_hasher.update(static_cast<iu64f>(this->size()));
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<typename _c> HashingString<_c>::HashingString () noexcept : hashedSize(0) {
+}
+
+template<typename _c> HashingString<_c>::HashingString (string<_c> s) noexcept : s(std::move(s)), hashedSize(0) {
+}
+
+template<typename _c> const string<_c> &HashingString<_c>::get () const noexcept {
+  return s;
+}
+
+template<typename _c> string<_c> HashingString<_c>::release () && noexcept {
+  hasher = Hasher();
+  hashedSize = 0;
+  return std::move(s);
+}
+
+template<typename _c> HashWrapper<string<_c>> HashingString<_c>::releaseHashed () && {
+  size_t h = hashSlow();
+  return HashWrapper<string<_c>>(PrecomputedHash{h}, std::move(*this).release());
+}
+
+template<typename _c> const _c *HashingString<_c>::data () const noexcept {
+  return s.data();
+}
+
+template<typename _c> _c *HashingString<_c>::data () noexcept {
+  hasher = Hasher();
+  hashedSize = 0;
+  return s.data();
+}
+
+template<typename _c> size_t HashingString<_c>::size () const noexcept {
+  return s.size();
+}
+
+template<typename _c> const _c *HashingString<_c>::begin () const noexcept {
+  return s.data();
+}
+
+template<typename _c> const _c *HashingString<_c>::end () const noexcept {
+  return s.data() + s.size();
+}
+
+template<typename _c> void HashingString<_c>::append (const _c *i, const _c *end) {
+  catchUp();
+  s.append(i, static_cast<size_t>(end - i));
+}
+
+template<typename _c> void HashingString<_c>::append (const string<_c> &o) {
+  catchUp();
+  s.append(o);
+}
+
+template<typename _c> void HashingString<_c>::push_back (_c c) {
+  catchUp();
+  s.push_back(c);
+}
+
+template<typename _c> _c *HashingString<_c>::append_any (size_t count) {
+  catchUp();
+  size_t oldSize = s.size();
+  s.append_any(count);
+  return s.data() + oldSize;
+}
+
+template<typename _c> void HashingString<_c>::truncate (size_t count) noexcept {
+  DPRE(count <= s.size());
+  if (count < hashedSize) {
+    hasher = Hasher();
+    hashedSize = 0;
+  }
+  s.erase(count);
+}
+
+template<typename _c> void HashingString<_c>::clear () noexcept {
+  s.clear();
+  hasher = Hasher();
+  hashedSize = 0;
+}
+
+template<typename _c> size_t HashingString<_c>::hashSlow () const noexcept {
+  if (hashedSize == s.size()) {
+    return hasher.finish();
+  }
+
+  Hasher h(hasher);
+  const _c *begin = s.data();
+  h.update(reinterpret_cast<const iu8f *>(begin + hashedSize), reinterpret_cast<const iu8f *>(begin + s.size()));
+  return h.finish();
+}
+
+template<typename _c> size_t HashingString<_c>::hashSlow (const HashKey &key) const noexcept {
+  return s.hashSlow(key);
+}
+
+template<typename _c> void HashingString<_c>::hashSlow (Hasher &r_hasher) const noexcept {
+  s.hashSlow(r_hasher);
+}
+
+template<typename _c> bool HashingString<_c>::operator== (const HashingString<_c> &r) const noexcept {
+  return s == r.s;
+}
+
+template<typename _c> void HashingString<_c>::catchUp () noexcept {
+  const _c *begin = s.data();
+  hasher.update(reinterpret_cast<const iu8f *>(begin + hashedSize), reinterpret_cast<const iu8f *>(begin + s.size()));
+  hashedSize = s.size();
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<hashing::Octet _c> template<size_t _n> consteval HashedLiteral<_c>::HashedLiteral (const _c (&literal)[_n]) noexcept :
+  first(literal), last(literal + _n - 1), h(hash(first, last))
+{
+  for (size_t i = 0; i != _n; ++i) {
+    if ((static_cast<iu8f>(literal[i]) == 0) != (i == _n - 1)) {
+      hashing::literalMustEndWithItsOnlyNullCharacter();
+    }
+  }
+}
+
+template<hashing::Octet _c> constexpr const _c *HashedLiteral<_c>::begin () const noexcept {
+  return first;
+}
+
+template<hashing::Octet _c> constexpr const _c *HashedLiteral<_c>::end () const noexcept {
+  return last;
+}
+
+template<hashing::Octet _c> constexpr size_t HashedLiteral<_c>::hashFast () const noexcept {
+  return h;
+}
+
+template<hashing::Octet _c> HashedLiteral<_c>::operator HashWrapper<string<_c>> () const {
+  return HashWrapper<string<_c>>(PrecomputedHash{h}, first, last);
+}
+
+template<hashing::Octet _c> bool operator== (const HashedLiteral<_c> &l, const HashWrapper<string<_c>> &r) noexcept {
+  const string<_c> &s = r.get();
+  size_t size = offset(l.begin(), l.end());
+  return l.hashFast() == r.hashFast() && size == s.size() && std::equal(l.begin(), l.end(), s.data());
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<hashing::Octet _c, bool _keyed> HashedView<_c, _keyed>::HashedView (const _c *i, const _c *end) noexcept :
+  first(i), last(end)
+{
+  auto byteI = reinterpret_cast<const iu8f *>(i);
+  auto byteEnd = reinterpret_cast<const iu8f *>(end);
+  if constexpr (_keyed) {
+    h = hash(byteI, byteEnd, getProcessHashKey());
+  } else {
+    h = hash(byteI, byteEnd);
+  }
+}
+
+template<hashing::Octet _c, bool _keyed> HashedView<_c, _keyed>::HashedView (const _c *s) noexcept :
+  HashedView(s, s + std::char_traits<_c>::length(s))
+{
+}
+
+template<hashing::Octet _c, bool _keyed> HashedView<_c, _keyed>::HashedView (const string<_c> &s) noexcept :
+  HashedView(s.data(), s.data() + s.size())
+{
+}
+
+template<hashing::Octet _c, bool _keyed> constexpr HashedView<_c, _keyed>::HashedView (const HashedLiteral<_c> &l) noexcept requires (!_keyed) :
+  first(l.begin()), last(l.end()), h(l.hashFast())
+{
+}
+
+template<hashing::Octet _c, bool _keyed> const _c *HashedView<_c, _keyed>::begin () const noexcept {
+  return first;
+}
+
+template<hashing::Octet _c, bool _keyed> const _c *HashedView<_c, _keyed>::end () const noexcept {
+  return last;
+}
+
+template<hashing::Octet _c, bool _keyed> size_t HashedView<_c, _keyed>::size () const noexcept {
+  return offset(first, last);
+}
+
+template<hashing::Octet _c, bool _keyed> size_t HashedView<_c, _keyed>::hashFast () const noexcept {
+  return h;
+}
+
+template<hashing::Octet _c, bool _keyed> bool operator== (const HashedView<_c, _keyed> &l, const HashWrapper<string<_c>, _keyed> &r) noexcept {
+  const string<_c> &s = r.get();
+  return l.hashFast() == r.hashFast() && l.size() == s.size() && std::equal(l.begin(), l.end(), s.data());
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<
+  bool _keyed, std::forward_iterator _InputIterator, typename _InputEndIterator, typename _OutputIterator
+> requires std::same_as<std::iter_value_t<_InputIterator>, string<typename std::iter_value_t<_InputIterator>::value_type>>
+void hashedBatch (_InputIterator i, const _InputEndIterator &end, _OutputIterator &r_ptr) {
+  typedef std::iter_value_t<_InputIterator> S;
+  const size_t batchSize = 32;
+  S *ss[batchSize];
+  const iu8f *is[batchSize];
+  const iu8f *ends[batchSize];
+  size_t hs[batchSize];
+
+  while (i != end) {
+    size_t count = 0;
+    for (; count != batchSize && i != end; ++count, ++i) {
+      S &s = *i;
+      ss[count] = &s;
+      is[count] = reinterpret_cast<const iu8f *>(s.data());
+      ends[count] = is[count] + s.size() * sizeof(typename S::value_type);
+    }
+
+    if constexpr (_keyed) {
+      hashBatch(is, ends, count, hs, getProcessHashKey());
+    } else {
+      hashBatch(is, ends, count, hs);
+    }
+    for (size_t j = 0; j != count; ++j) {
+      *(r_ptr++) = HashWrapper<S, _keyed>(PrecomputedHash{hs[j]}, std::move(*ss[j]));
+    }
+  }
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+template<typename _c> Interned<_c>::Interned (const _c *chars) noexcept : chars(chars) {
+}
+
+template<typename _c> const _c *Interned<_c>::data () const noexcept {
+  return chars;
+}
+
+template<typename _c> size_t Interned<_c>::size () const noexcept {
+  return (reinterpret_cast<const Header *>(chars) - 1)->size;
+}
+
+template<typename _c> const _c *Interned<_c>::begin () const noexcept {
+  return chars;
+}
+
+template<typename _c> const _c *Interned<_c>::end () const noexcept {
+  return chars + size();
+}
+
+template<typename _c> size_t Interned<_c>::hashFast () const noexcept {
+  return (reinterpret_cast<const Header *>(chars) - 1)->h;
+}
+
+template<typename _c> bool Interned<_c>::operator== (const Interned<_c> &r) const noexcept {
+  return chars == r.chars;
+}
+
+template<typename _c> size_t Interner<_c>::Key::hashFast () const noexcept {
+  return h;
+}
+
+template<typename _c> bool Interner<_c>::Key::operator== (const Key &r) const noexcept {
+  return h == r.h && size == r.size && memcmp(chars, r.chars, size * sizeof(_c)) == 0;
+}
+
+// Each string is held as an Interned::Header followed by its characters and a
+// null character. Blocks are chained through a pointer to the previous block
+// at their start.
+template<typename _c> Interner<_c>::Interner () noexcept : lastBlock(nullptr), blockPtr(nullptr), blockLeft(0) {
+}
+
+template<typename _c> Interner<_c>::~Interner () noexcept {
+  while (lastBlock) {
+    iu8f *block = lastBlock;
+    lastBlock = *reinterpret_cast<iu8f **>(block);
+    delete[] block;
+  }
+}
+
+template<typename _c> Interned<_c> Interner<_c>::intern (const _c *i, const _c *end) {
+  size_t size = offset(i, end);
+  return internHashed(i, size, hashChars(i, size));
+}
+
+template<typename _c> Interned<_c> Interner<_c>::intern (const string<_c> &s) {
+  return internHashed(s.data(), s.size(), hashChars(s.data(), s.size()));
+}
+
+template<typename _c> Interned<_c> Interner<_c>::intern (const HashWrapper<string<_c>> &s) {
+  return internHashed(s.get().data(), s.get().size(), s.hashFast());
+}
+
+template<typename _c> std::optional<Interned<_c>> Interner<_c>::find (const _c *i, const _c *end) const {
+  size_t size = offset(i, end);
+  const _c *chars = findHashed(i, size, hashChars(i, size));
+  if (!chars) {
+    return std::nullopt;
+  }
+  return std::optional<Interned<_c>>(Interned<_c>(chars));
+}
+
+template<typename _c> size_t Interner<_c>::size () const noexcept {
+  return keys.size();
+}
+
+template<typename _c> size_t Interner<_c>::hashChars (const _c *i, size_t size) noexcept {
+  return hash(reinterpret_cast<const iu8f *>(i), reinterpret_cast<const iu8f *>(i + size));
+}
+
+template<typename _c> const _c *Interner<_c>::findHashed (const _c *i, size_t size, size_t h) const noexcept {
+  auto k = keys.find(Key{i, size, h});
+  return k == keys.end() ? nullptr : k->chars;
+}
+
+template<typename _c> Interned<_c> Interner<_c>::internHashed (const _c *i, size_t size, size_t h) {
+  typedef typename Interned<_c>::Header Header;
+  DSA(alignof(Header) >= alignof(_c) && sizeof(Header) % alignof(_c) == 0, "the characters must be aligned after the header");
+
+  const _c *chars = findHashed(i, size, h);
+  if (chars) {
+    return Interned<_c>(chars);
+  }
+
+  const size_t align = alignof(Header);
+  size_t recordSize = (sizeof(Header) + (size + 1) * sizeof(_c) + align - 1) / align * align;
+  if (recordSize > blockLeft) {
+    size_t linkSize = (sizeof(iu8f *) + align - 1) / align * align;
+    size_t newBlockSize = std::max(blockSize, linkSize + recordSize);
+    iu8f *block = new iu8f[newBlockSize];
+    *reinterpret_cast<iu8f **>(block) = lastBlock;
+    lastBlock = block;
+    blockPtr = block + linkSize;
+    blockLeft = newBlockSize - linkSize;
+  }
+
+  Header *header = new (blockPtr) Header{h, size};
+  _c *newChars = reinterpret_cast<_c *>(header + 1);
+  memcpy(newChars, i, size * sizeof(_c));
+  newChars[size] = 0;
+  keys.insert(Key{newChars, size, h});
+  blockPtr += recordSize;
+  blockLeft -= recordSize;
+  return Interned<_c>(newChars);
+}
+
+template<typename _c> ConcurrentInterner<_c>::ConcurrentInterner (size_t shardCount) {
+  DPRE(shardCount != 0);
+
+  size_t count = 1;
+  while (count < shardCount) {
+    count *= 2;
+  }
+  shards.reset(new Shard[count]);
+  shardMask = count - 1;
+}
+
+template<typename _c> Interned<_c> ConcurrentInterner<_c>::intern (const _c *i, const _c *end) {
+  size_t size = offset(i, end);
+  return internHashed(i, size, Interner<_c>::hashChars(i, size));
+}
+
+template<typename _c> Interned<_c> ConcurrentInterner<_c>::intern (const string<_c> &s) {
+  return internHashed(s.data(), s.size(), Interner<_c>::hashChars(s.data(), s.size()));
+}
+
+template<typename _c> Interned<_c> ConcurrentInterner<_c>::intern (const HashWrapper<string<_c>> &s) {
+  return internHashed(s.get().data(), s.get().size(), s.hashFast());
+}
+
+template<typename _c> std::optional<Interned<_c>> ConcurrentInterner<_c>::find (const _c *i, const _c *end) const {
+  size_t size = offset(i, end);
+  size_t h = Interner<_c>::hashChars(i, size);
+  const Shard &shard = getShard(h);
+  std::shared_lock<std::shared_mutex> lock(shard.mutex);
+  const _c *chars = shard.interner.findHashed(i, size, h);
+  if (!chars) {
+    return std::nullopt;
+  }
+  return std::optional<Interned<_c>>(Interned<_c>(chars));
+}
+
+template<typename _c> size_t ConcurrentInterner<_c>::size () const {
+  size_t count = 0;
+  for (size_t i = 0; i <= shardMask; ++i) {
+    std::shared_lock<std::shared_mutex> lock(shards[i].mutex);
+    count += shards[i].interner.size();
+  }
+  return count;
+}
+
+// Most strings will already be held, so look for the string under the lock
+// for reading first (and look again under the lock for writing if it isn't).
+template<typename _c> Interned<_c> ConcurrentInterner<_c>::internHashed (const _c *i, size_t size, size_t h) {
+  Shard &shard = getShard(h);
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    const _c *chars = shard.interner.findHashed(i, size, h);
+    if (chars) {
+      return Interned<_c>(chars);
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  return shard.interner.internHashed(i, size, h);
+}
+
+template<typename _c> typename ConcurrentInterner<_c>::Shard &ConcurrentInterner<_c>::getShard (size_t h) const noexcept {
+  return shards[static_cast<size_t>(hashing::mum(static_cast<iu64f>(h), hashing::hashPrime1)) & shardMask];
 }
 
 /* -----------------------------------------------------------------------------
@@ -20,6 +20,20 @@ int main (int argc, char *argv[]) {
       testDebugAssertionFailure0Impl();
     } else if (strcmp(arg, "DebugAssertionFailure1") == 0) {
       testDebugAssertionFailure1Impl();
+    } else if (strcmp(arg, "BenchmarkHash") == 0) {
+      benchmarkHash();
+    } else if (strcmp(arg, "BenchmarkConcurrentHashMap") == 0) {
+      benchmarkConcurrentHashMap();
+    } else if (strcmp(arg, "BenchmarkBloomFilter") == 0) {
+      benchmarkBloomFilter();
+    } else if (strcmp(arg, "BenchmarkChunker") == 0) {
+      benchmarkChunker();
+    } else if (strcmp(arg, "BenchmarkIex") == 0) {
+      benchmarkIex();
+    } else if (strcmp(arg, "BenchmarkDeltaSequence") == 0) {
+      benchmarkDeltaSequence();
+    } else if (strcmp(arg, "BenchmarkOctetStreams") == 0) {
+      benchmarkOctetStreams();
     }
     return 0;
   }
@@ -37,7 +51,30 @@ int main (int argc, char *argv[]) {
   testShifting();
   testSetAndGet();
   testIex();
+  testIexArrays();
+  testIpx();
+  testHash();
+  testHasher();
   testHashing();
+  testCompositeHashing();
+  testCompactHashWrapper();
+  testHashingString();
+  testRollingHash();
+  testChunker();
+  testKeyedHashing();
+  testHashBatch();
+  testConstantHashing();
+  testHashedView();
+  testHashAvalanche();
+  testHashDistribution();
+  testFlatHashSet();
+  testFlatHashMap();
+  testConcurrentHashMap();
+  testInterner();
+  testConcurrentInterner();
+  testBloomFilter();
+  testDeltaSequence();
+  testOctetStreams();
   testUnicodeCodeUnits();
 
   return 0;
@@ -72,5 +109,34 @@ tuple<int, vector<std::string>> rerun (const char *arg) {
   return tuple<int, vector<std::string>>(move(rc), move(stderrLines));
 }
 
+Random::Random (iu64f seed) noexcept : state(seed) {
+}
+
+iu64f Random::next () noexcept {
+  iu64f z = (state += 0x9E3779B97F4A7C15U);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9U;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBU;
+  return z ^ (z >> 31);
+}
+
+iu64f Random::nextOfAnySize () noexcept {
+  iu64f value = next();
+  return value >> (next() % 64);
+}
+
+void Random::fill (iu8f *i, iu8f *end) noexcept {
+  for (; i != end; ++i) {
+    *i = static_cast<iu8f>(next());
+  }
+}
+
+core::u8string createKey (size_t n) {
+  core::u8string s(u8"key-");
+  for (; n != 0; n /= 10) {
+    s.push_back(static_cast<char8_t>(u8'0' + n % 10));
+  }
+  return s;
+}
+
 /* -----------------------------------------------------------------------------
 ----------------------------------------------------------------------------- */
@@ -218,8 +218,10 @@ def main (args):
           "    upb negativeIes;\n" +
           "  } valueData[] = {\n")
   for value in genValues():
+    # Each array has a spare octet, as the reading tests claim a range one
+    # octet longer than the value.
     def r (bs):
-      return ", " + str(len(bs)) + ", upb(new iu8f[" + str(len(bs)) + "]{" + ", ".join((renderHexInteger(b, 2) for b in bs)) + "})"
+      return ", " + str(len(bs)) + ", upb(new iu8f[" + str(len(bs) + 1) + "]{" + ", ".join((renderHexInteger(b, 2) for b in bs)) + "})"
     f.write("    {" + renderHexInteger(value) + ", static_cast<sgnd>(" + renderSignExtendedHexInteger(value) + ")" + r(makeIeuBytes(value)) + r(makeIesBytes(value, SUPERBIGTYPE_BITS + 1)) + r(makeIesBytes(value, countBits(value) - 1)) + "},\n")
   f.write("  };\n")
   for typeSgn in SGN:
@@ -272,7 +274,7 @@ def main (args):
               "      } else   if (iex == valueDatum.ieu.get())      {\n" +
               "        try {\n" +
               "          iu8f *bi = iex;\n" +
-              "          readIe" + typeSgn + "<" + type + ">(bi, bi + 1000);\n" +
+              "          readIe" + typeSgn + "<" + type + ">(bi, bi + iexSize + 1);\n" +
               "          check(false);\n" +
               "        } catch (...) {\n" +
               "        }\n" +
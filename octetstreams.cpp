@@ -0,0 +1,310 @@
+#include "header.hpp"
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#ifdef OS_POSIX
+#include <cstdlib>
+#include <unistd.h>
+#endif
+
+using core::check;
+using core::OctetSource;
+using core::OctetSink;
+using core::PlainException;
+using std::vector;
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */
+namespace {
+
+// Supplies the octets of a vector at most pieceSize at a time.
+class VectorOctetSource : public OctetSource {
+  prv const vector<iu8f> &octets;
+  prv size_t index;
+  prv size_t pieceSize;
+
+  pub VectorOctetSource (const vector<iu8f> &octets, size_t capacity, size_t pieceSize) : OctetSource(capacity), octets(octets), index(0), pieceSize(pieceSize) {
+  }
+
+  prv size_t supply (iu8f *out, size_t size) override {
+    size_t count = std::min({size, pieceSize, octets.size() - index});
+    std::copy_n(octets.begin() + static_cast<ptrdiff_t>(index), count, out);
+    index += count;
+    return count;
+  }
+};
+
+class VectorOctetSink : public OctetSink {
+  prv vector<iu8f> &octets;
+
+  pub VectorOctetSink (vector<iu8f> &octets, size_t capacity) : OctetSink(capacity), octets(octets) {
+  }
+
+  prv void consume (const iu8f *ptr, size_t size) override {
+    octets.insert(octets.end(), ptr, ptr + size);
+  }
+};
+
+vector<iu64f> createValues (size_t count, Random &r_random) {
+  vector<iu64f> values;
+  for (size_t n = 0; n != count; ++n) {
+    values.push_back(r_random.nextOfAnySize());
+  }
+  return values;
+}
+
+void testRoundTrip (const vector<iu64f> &values, size_t capacity, size_t pieceSize) {
+  vector<iu8f> expected;
+  auto out = std::back_inserter(expected);
+  for (iu64f value : values) {
+    core::writeIeu(out, value);
+    core::writeIes(out, static_cast<is64f>(value));
+    core::writeIeu(out, static_cast<iu32f>(value));
+  }
+
+  vector<iu8f> octets;
+  {
+    VectorOctetSink sink(octets, capacity);
+    for (iu64f value : values) {
+      core::writeIeu(sink, value);
+      core::writeIes(sink, static_cast<is64f>(value));
+      core::writeIeu(sink, static_cast<iu32f>(value));
+    }
+    sink.flush();
+  }
+  check(expected.begin(), expected.end(), octets.begin(), octets.end());
+
+  VectorOctetSource source(octets, capacity, pieceSize);
+  for (iu64f value : values) {
+    check(value, core::readIeu<iu64f>(source));
+    check(static_cast<is64f>(value), core::readIes<is64f>(source));
+    check(static_cast<iu32f>(value), core::readIeu<iu32f>(source));
+  }
+  check(source.isExhausted());
+
+  // Check that truncation is noticed (and that the values before it are read).
+  for (size_t size = 0; size < octets.size(); size += 1 + size / 3) {
+    vector<iu8f> truncatedOctets(octets.begin(), octets.begin() + static_cast<ptrdiff_t>(size));
+    VectorOctetSource truncatedSource(truncatedOctets, capacity, pieceSize);
+    bool truncated = false;
+    try {
+      for (size_t i = 0; i != values.size(); ++i) {
+        core::readIeu<iu64f>(truncatedSource);
+        core::readIes<is64f>(truncatedSource);
+        core::readIeu<iu32f>(truncatedSource);
+      }
+    } catch (const PlainException &) {
+      truncated = true;
+    }
+    check(truncated);
+  }
+}
+
+void testBulk (size_t capacity, size_t pieceSize) {
+  vector<iu8f> octets;
+  for (size_t i = 0; i != 1000; ++i) {
+    octets.push_back(static_cast<iu8f>(i * 7));
+  }
+
+  vector<iu8f> written;
+  {
+    VectorOctetSink sink(written, capacity);
+    sink.write(octets.data(), octets.data() + 3);
+    sink.write(octets.data() + 3, octets.data() + 500);
+    sink.write(octets.data() + 500, octets.data() + 1000);
+    sink.flush();
+  }
+  check(octets.begin(), octets.end(), written.begin(), written.end());
+
+  VectorOctetSource source(octets, capacity, pieceSize);
+  vector<iu8f> read(1200);
+  check(3U, source.read(read.data(), 3));
+  check(497U, source.read(read.data() + 3, 497));
+  check(500U, source.read(read.data() + 500, 700));
+  check(octets.begin(), octets.end(), read.begin(), read.begin() + 1000);
+  check(0U, source.read(read.data(), 1));
+  check(source.isExhausted());
+}
+
+// Checks that values that overflow are thrown on (whether they are read within
+// the window or not), and that windows too small for the longest value are
+// rejected.
+void testInvalid () {
+  const vector<vector<iu8f>> badOctets = {
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02},
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00},
+    {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x42}
+  };
+  for (const vector<iu8f> &octets : badOctets) {
+    for (size_t capacity : {10U, 64U}) {
+      for (bool isSigned : {false, true}) {
+        VectorOctetSource source(octets, capacity, 1000);
+        bool overflowed = false;
+        try {
+          if (isSigned) {
+            core::readIes<is64f>(source);
+          } else {
+            core::readIeu<iu64f>(source);
+          }
+        } catch (const std::overflow_error &) {
+          overflowed = true;
+        }
+        check(overflowed);
+      }
+    }
+  }
+
+  vector<iu8f> octets;
+  for (size_t capacity : {0U, 9U}) {
+    bool rejected = false;
+    try {
+      VectorOctetSource source(octets, capacity, 1000);
+    } catch (const std::invalid_argument &) {
+      rejected = true;
+    }
+    check(rejected);
+    rejected = false;
+    try {
+      VectorOctetSink sink(octets, capacity);
+    } catch (const std::invalid_argument &) {
+      rejected = true;
+    }
+    check(rejected);
+  }
+}
+
+void testFiles () {
+  FILE *file = tmpfile();
+  check(file != nullptr);
+  Random random(2);
+  vector<iu64f> values = createValues(10000, random);
+  {
+    core::FileOctetSink sink(file, 100);
+    for (iu64f value : values) {
+      core::writeIeu(sink, value);
+    }
+  }
+
+  rewind(file);
+  core::FileOctetSource source(file, 100);
+  for (iu64f value : values) {
+    check(value, core::readIeu<iu64f>(source));
+  }
+  check(source.isExhausted());
+  fclose(file);
+}
+
+#ifdef OS_POSIX
+void testMappedFile () {
+  char pathName[] = "/tmp/coretestXXXXXX";
+  int fd = mkstemp(pathName);
+  check(fd != -1);
+  FILE *file = fdopen(fd, "wb");
+  check(file != nullptr);
+  core::MappedFile emptyMapped(pathName);
+  check(0U, emptyMapped.getSize());
+  check(emptyMapped.begin() == emptyMapped.end());
+
+  Random random(4);
+  vector<iu64f> values = createValues(100000, random);
+  {
+    core::FileOctetSink sink(file);
+    for (iu64f value : values) {
+      core::writeIeu(sink, value);
+      core::writeIes(sink, static_cast<is64f>(value));
+    }
+  }
+  fclose(file);
+
+  core::MappedFile mapped(pathName);
+  unlink(pathName);
+  const iu8f *ptr = mapped.begin();
+  const iu8f *ptrEnd = mapped.end();
+  check(mapped.getSize(), core::offset(ptr, ptrEnd));
+  mapped.prefetch(ptr + 1, ptr + 5000);
+  for (iu64f value : values) {
+    check(value, core::readIeu<iu64f>(ptr, ptrEnd));
+    check(static_cast<is64f>(value), core::readIes<is64f>(ptr, ptrEnd));
+  }
+  check(ptrEnd == ptr);
+
+  core::MappedFile moved(std::move(mapped));
+  check(mapped.begin() == mapped.end());
+  moved.advise(core::MappedFile::Access::random);
+  ptr = moved.begin();
+  check(values[0], core::readIeu<iu64f>(ptr, moved.end()));
+
+  bool failed = false;
+  try {
+    core::MappedFile missing(pathName);
+  } catch (const PlainException &) {
+    failed = true;
+  }
+  check(failed);
+}
+#endif
+
+}
+
+void testOctetStreams () {
+  Random random(1);
+  for (size_t count : {0U, 1U, 100U}) {
+    vector<iu64f> values = createValues(count, random);
+    for (size_t capacity : {10U, 11U, 64U, 65536U}) {
+      for (size_t pieceSize : {1U, 3U, 1000U}) {
+        testRoundTrip(values, capacity, pieceSize);
+      }
+    }
+  }
+
+  testBulk(10, 3);
+  testBulk(64, 1000);
+  testBulk(65536, 7);
+  testInvalid();
+  testFiles();
+  #ifdef OS_POSIX
+  testMappedFile();
+  #endif
+}
+
+void benchmarkOctetStreams () {
+  typedef std::chrono::steady_clock Clock;
+  Random random(3);
+  const size_t count = 1 << 22;
+  vector<iu64f> values;
+  for (size_t n = 0; n != count; ++n) {
+    values.push_back(random.nextOfAnySize() >> (random.next() % 24));
+  }
+  vector<iu8f> octets;
+  auto out = std::back_inserter(octets);
+  for (iu64f value : values) {
+    core::writeIeu(out, value);
+  }
+
+  vector<iu64f> decoded(count);
+  double nss[2];
+  for (size_t i = 0; i != 2; ++i) {
+    auto start = Clock::now();
+    if (i == 0) {
+      const iu8f *ptr = octets.data();
+      const iu8f *ptrEnd = ptr + octets.size();
+      for (size_t n = 0; n != count; ++n) {
+        decoded[n] = core::readIeu<iu64f>(ptr, ptrEnd);
+      }
+    } else {
+      VectorOctetSource source(octets, 65536, 65536);
+      for (size_t n = 0; n != count; ++n) {
+        decoded[n] = core::readIeu<iu64f>(source);
+      }
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    nss[i] = static_cast<double>(ns) / static_cast<double>(count);
+    check(values.begin(), values.end(), decoded.begin(), decoded.end());
+  }
+  printf("iu64fs (%.2f octets each): readIeu from octets %.2f ns, from OctetSource %.2f ns per value\n", static_cast<double>(octets.size()) / static_cast<double>(count), nss[0], nss[1]);
+}
+
+/* -----------------------------------------------------------------------------
+----------------------------------------------------------------------------- */